@@ -1,12 +1,49 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
 #include <vector>
+#include <zlib.h>
 
+#include "NameMatcher.hpp"
 #include "cache/ConnR.hpp"
+#include "cache/ConnRW.hpp"
+#include "cache/Index.hpp"
+#include "cache/Snapshot.hpp"
+#include "update/Decompressor.hpp"
+#include "update/Downloader.hpp"
+#include "update/Reader.hpp"
 #include "utils.hpp"
 
+// Number of heap allocations made by the benchmark binary. Used to compare
+// the allocation cost of result containers.
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
 TEST_CASE("ConnR::find_by_addr") {
     // Each entry requires more placeholders than the previous one.
     const std::array<std::string, 4> test_values = {
@@ -59,4 +96,531 @@ TEST_CASE("ConnR::find_by_addr") {
     BENCHMARK("1000 terms") {
         return conn.find_by_addr(addresses);
     };
+
+    const Index index{conn};
+
+    BENCHMARK("Index: 1 term") {
+        return index.find_by_addr({addresses.data(), 1});
+    };
+
+    BENCHMARK("Index: 4 terms") {
+        return index.find_by_addr({addresses.data(), 4});
+    };
+
+    BENCHMARK("Index: 10 terms") {
+        return index.find_by_addr({addresses.data(), 10});
+    };
+
+    BENCHMARK("Index: 52 terms") {
+        return index.find_by_addr({addresses.data(), 52});
+    };
+
+    BENCHMARK("Index: 100 terms") {
+        return index.find_by_addr({addresses.data(), 100});
+    };
+
+    BENCHMARK("Index: 1000 terms") {
+        return index.find_by_addr(addresses);
+    };
+}
+
+// Measures searches in which every term matches, so that the cost
+// of gathering and de-duplicating results dominates.
+TEST_CASE("ConnR: matching terms") {
+    const std::array<std::string, 4> test_values = {
+        "00:00:0C",
+        "00:00:0C:12:34:56",
+        "00:00:AA:12:34:56",
+        "00:48:54",
+    };
+
+    constexpr size_t T = 1000;
+
+    std::vector<std::string> addresses{};
+    addresses.reserve(T);
+
+    for (size_t i = 0; i < T; i++) {
+        addresses.push_back(test_values[i % test_values.size()]);
+    }
+
+    const std::vector<std::string> names(T, "o");
+
+    ConnR conn{"testdata/sample.db", true};
+
+    size_t before = allocations;
+    REQUIRE(conn.find_by_addr(addresses).size() == 3);
+    WARN("find_by_addr: 1000 matching terms: " << allocations - before << " allocations");
+
+    before = allocations;
+    REQUIRE(conn.find_by_name(names).size() == 2);
+    WARN("find_by_name: 1000 matching terms: " << allocations - before << " allocations");
+
+    BENCHMARK("find_by_addr: 1000 matching terms") {
+        return conn.find_by_addr(addresses);
+    };
+
+    BENCHMARK("find_by_name: 1000 matching terms") {
+        return conn.find_by_name(names);
+    };
+
+    const Index index{conn};
+
+    BENCHMARK("Index: 1000 matching terms") {
+        return index.find_by_addr(addresses);
+    };
+}
+
+// Compares per-address statement stepping with single-statement resolution.
+TEST_CASE("ConnR::find_by_addr_batch") {
+    const std::array<std::string, 4> test_values = {
+        "000000",
+        "741AE0C",
+        "0050C2003",
+        "024201234567",
+    };
+
+    constexpr size_t T = 1'000'000;
+
+    std::vector<std::string> addresses{};
+    addresses.reserve(T);
+
+    for (size_t i = 0; i < T; i++) {
+        addresses.push_back(test_values[i % test_values.size()]);
+    }
+
+    ConnR conn{"testdata/sample.db", true};
+
+    BENCHMARK("find_by_addr: 1k terms") {
+        return conn.find_by_addr({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_by_addr_batch: 1k terms") {
+        return conn.find_by_addr_batch({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_by_addr: 100k terms") {
+        return conn.find_by_addr({addresses.data(), 100'000});
+    };
+
+    BENCHMARK("find_by_addr_batch: 100k terms") {
+        return conn.find_by_addr_batch({addresses.data(), 100'000});
+    };
+
+    BENCHMARK("find_by_addr: 1M terms") {
+        return conn.find_by_addr(addresses);
+    };
+
+    BENCHMARK("find_by_addr_batch: 1M terms") {
+        return conn.find_by_addr_batch(addresses);
+    };
+}
+
+// Compares resolution of every matching block with the most specific lookup.
+TEST_CASE("ConnR::find_best_by_addr") {
+    const std::array<std::string, 4> test_values = {
+        "000000",
+        "741AE0C",
+        "0050C2003",
+        "024201234567",
+    };
+
+    constexpr size_t T = 100'000;
+
+    std::vector<std::string> addresses{};
+    addresses.reserve(T);
+
+    for (size_t i = 0; i < T; i++) {
+        addresses.push_back(test_values[i % test_values.size()]);
+    }
+
+    ConnR conn{"testdata/sample.db", true};
+
+    BENCHMARK("find_by_addr: 1k terms") {
+        return conn.find_by_addr({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_best_by_addr: 1k terms") {
+        return conn.find_best_by_addr({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_by_addr: 100k terms") {
+        return conn.find_by_addr(addresses);
+    };
+
+    BENCHMARK("find_best_by_addr: 100k terms") {
+        return conn.find_best_by_addr(addresses);
+    };
+}
+
+// Measures snapshot lookups of addresses spread over the whole OUI space,
+// against a registry of roughly the size of the IEEE one.
+TEST_CASE("Snapshot::find_by_addr") {
+    const std::string db_path   = "testdata/bench_snapshot.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    // Scatters blocks with a multiplicative hash. Like in the IEEE registry,
+    // a few hundred OUIs are divided into MA-M and MA-S blocks.
+    constexpr auto scatter = [](const uint64_t i) -> int64_t {
+        return static_cast<int64_t>(i * 2654435761u % 0x1000000);
+    };
+
+    VendorList records;
+
+    for (uint64_t i = 0; i < 40'000; i++) {
+        const int64_t oui = scatter(i);
+
+        records.emplace_back(oui, 6, "Vendor", false, Registry::MA_L, "2015/11/17");
+
+        if (i % 100 == 0) {
+            for (int64_t j = 0; j < 16; j++) {
+                records.emplace_back(oui << 4 | j, 7, "Vendor", false, Registry::MA_M, "2019/07/02");
+            }
+        }
+
+        if (i % 1000 == 1) {
+            for (int64_t j = 0; j < 256; j++) {
+                records.emplace_back(oui << 12 | 0xA00 | j, 9, "Vendor", false, Registry::MA_S, "2022/07/19");
+            }
+        }
+    }
+
+    Snapshot::write(snap_path, db_path, records);
+
+    const Snapshot snap{snap_path, db_path};
+
+    constexpr size_t T = 100'000;
+
+    std::vector<std::string> addresses{};
+    addresses.reserve(T);
+
+    // Roughly half of the addresses belong to a known block
+    for (uint64_t i = 0; i < T; i++) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%06llXAFFC12", static_cast<unsigned long long>(scatter(i * 37 % 80'000)));
+        addresses.emplace_back(buf);
+    }
+
+    BENCHMARK("find_by_addr: 1k terms") {
+        return snap.find_by_addr({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_best_by_addr: 1k terms") {
+        return snap.find_best_by_addr({addresses.data(), 1'000});
+    };
+
+    BENCHMARK("find_by_addr: 100k terms") {
+        return snap.find_by_addr(addresses);
+    };
+
+    BENCHMARK("find_best_by_addr: 100k terms") {
+        return snap.find_best_by_addr(addresses);
+    };
+}
+
+// Measures name searches against a database of the size of the IEEE registry.
+TEST_CASE("ConnR::find_by_name") {
+    const std::string db_path = "testdata/bench_names.db";
+
+    const std::array<std::string, 8> places = {
+        "Shenzhen", "Hangzhou", "Beijing", "Tokyo", "Seoul", "Berlin", "Austin", "Taipei",
+    };
+
+    const std::array<std::string, 16> words = {
+        "Micro", "Net", "Tele", "Data", "Opto", "Smart", "Cloud", "Digi",
+        "Electro", "Info", "Power", "Sys", "Wave", "Link", "Tech", "Vision",
+    };
+
+    const std::array<std::string, 8> suffixes = {
+        "Technology Co., Ltd", "Inc.", "GmbH", "Corporation", "Electronics Co.,Ltd", "LLC", "Systems AG", "Communications Ltd",
+    };
+
+    constexpr size_t N = 50'000;
+
+    std::filesystem::remove(db_path);
+
+    {
+        std::stringstream csv;
+        csv << "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n";
+
+        for (size_t i = 0; i < N; i++) {
+            const size_t h = i * 2654435761u;
+
+            const std::string name = places[h % 8] + ' ' + words[h / 8 % 16] + words[h / 128 % 16] + words[h / 2048 % 16] + ' ' + suffixes[h / 32768 % 8];
+
+            csv << prefix_to_string(static_cast<int64_t>(i), 6) << ",\"" << name << "\",false,MA-L,2015/11/17\n";
+        }
+
+        ConnRW conn_rw{db_path, true};
+
+        std::ostringstream warnings;
+        conn_rw.insert(csv, false, warnings);
+    }
+
+    const std::vector<std::string> names = {
+        "MicroNetTele", "cloudwavelink", "DigiSysVision", "infopowertech", "OptoSmartData",
+        "electrolinknet", "TechTechTech", "wavemicrosys", "non-existent", "berlin visionopto",
+    };
+
+    ConnR conn{db_path, true};
+
+    REQUIRE(conn.find_by_name(names).size() > 0);
+
+    BENCHMARK("1 term") {
+        return conn.find_by_name({names.data(), 1});
+    };
+
+    BENCHMARK("10 terms") {
+        return conn.find_by_name(names);
+    };
+
+    // Full names and their leading words, resolved through the index
+    // of normalized names
+    const std::vector<std::string> exact_names = {
+        "Shenzhen MicroNetTele Technology Co., Ltd", "Tokyo CloudWaveLink Inc.", "Berlin DigiSysVision GmbH",
+        "Austin InfoPowerTech LLC", "Seoul OptoSmartData Corporation", "Taipei ElectroLinkNet Systems AG",
+        "Beijing TechTechTech Communications Ltd", "Hangzhou WaveMicroSys Inc.", "non-existent", "Berlin VisionOpto",
+    };
+
+    const std::vector<std::string> prefixes = {
+        "shenzhen micro", "tokyo cloud", "berlin digi", "austin info", "seoul opto",
+        "taipei electro", "beijing tech", "hangzhou wave", "non-existent", "berlin visionopto",
+    };
+
+    REQUIRE(conn.find_exact(exact_names).size() > 0);
+    REQUIRE(conn.find_prefix(prefixes).size() > 0);
+
+    // Terms without a run of 3 literal characters, which the trigram
+    // index cannot narrow down
+    const std::vector<std::string> short_names = {"yo", "zz", "x_z", "%jk%"};
+
+    REQUIRE(conn.find_by_name(short_names).size() > 0);
+
+    BENCHMARK("unindexed: 1 term") {
+        return conn.find_by_name({short_names.data(), 1});
+    };
+
+    BENCHMARK("unindexed: 4 terms") {
+        return conn.find_by_name(short_names);
+    };
+
+    BENCHMARK("exact: 10 terms") {
+        return conn.find_exact(exact_names);
+    };
+
+    BENCHMARK("prefix: 10 terms") {
+        return conn.find_prefix(prefixes);
+    };
+
+    const std::vector<std::string> misspelled = {"shenzen micronettele", "cloud wave link", "DigiSysVison"};
+
+    REQUIRE(conn.find_fuzzy(misspelled, 5).size() > 0);
+
+    BENCHMARK("fuzzy: 1 term, first call") {
+        return ConnR{db_path, true}.find_fuzzy({misspelled.data(), 1}, 5);
+    };
+
+    BENCHMARK("fuzzy: 1 term") {
+        return conn.find_fuzzy({misspelled.data(), 1}, 5);
+    };
+
+    const Index index{conn};
+
+    REQUIRE(index.find_by_name(names) == conn.find_by_name(names));
+
+    BENCHMARK("Index: 1 term") {
+        return index.find_by_name({names.data(), 1});
+    };
+
+    BENCHMARK("Index: 10 terms") {
+        return index.find_by_name(names);
+    };
+
+    // Watch-list of every brand, resolved per term in portions too small
+    // for a single pass, and at once.
+    std::vector<std::string> brands;
+    for (const auto& a : words) {
+        for (const auto& b : words) {
+            brands.push_back(a + b + "Micro");
+            if (brands.size() == 1000) {
+                break;
+            }
+        }
+    }
+
+    constexpr size_t PORTION = NameMatcher::MIN_TERMS - 1;
+
+    BENCHMARK("1000 terms, per term") {
+        size_t n = 0;
+        for (size_t i = 0; i < brands.size(); i += PORTION) {
+            n += conn.find_by_name({brands.data() + i, std::min(PORTION, brands.size() - i)}).size();
+        }
+        return n;
+    };
+
+    BENCHMARK("1000 terms, single pass") {
+        return conn.find_by_name(brands);
+    };
+
+    BENCHMARK("Index: 1000 terms, single pass") {
+        return index.find_by_name(brands);
+    };
+
+    BENCHMARK("16 terms, per term") {
+        return conn.find_by_name({brands.data(), PORTION}).size() + conn.find_by_name({brands.data() + PORTION, 1}).size();
+    };
+
+    BENCHMARK("16 terms, single pass") {
+        return conn.find_by_name({brands.data(), NameMatcher::MIN_TERMS});
+    };
+}
+
+// Measures approximate name searches through the trigram index of a snapshot
+// holding as many distinct names as the IEEE registry.
+TEST_CASE("Snapshot::find_fuzzy") {
+    const std::string db_path   = "testdata/bench_fuzzy.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    const std::array<std::string, 8> places = {
+        "Shenzhen", "Hangzhou", "Beijing", "Tokyo", "Seoul", "Berlin", "Austin", "Taipei",
+    };
+
+    const std::array<std::string, 16> words = {
+        "Micro", "Net", "Tele", "Data", "Opto", "Smart", "Cloud", "Digi",
+        "Electro", "Info", "Power", "Sys", "Wave", "Link", "Tech", "Vision",
+    };
+
+    const std::array<std::string, 8> suffixes = {
+        "Technology Co., Ltd", "Inc.", "GmbH", "Corporation", "Electronics Co.,Ltd", "LLC", "Systems AG", "Communications Ltd",
+    };
+
+    VendorList records;
+
+    for (uint64_t i = 0; i < 50'000; i++) {
+        const size_t h = i * 2654435761u;
+
+        const std::string name = places[h % 8] + ' ' + words[h / 8 % 16] + words[h / 128 % 16] + words[h / 2048 % 16] + ' ' + suffixes[h / 32768 % 8];
+
+        records.emplace_back(static_cast<int64_t>(i), 6, name, false, Registry::MA_L, "2015/11/17");
+    }
+
+    Snapshot::write(snap_path, db_path, records);
+
+    const Snapshot snap{snap_path, db_path};
+
+    const std::vector<std::string> names = {
+        "shenzen micronettele", "cloud wave link", "DigiSysVison", "infopower tech", "OptoSmartDta",
+        "electro link net", "techtechteck", "wave micro sys", "non-existent", "berlin visonopto",
+    };
+
+    REQUIRE(snap.find_fuzzy({names.data(), 1}, 5).size() > 0);
+
+    BENCHMARK("find_fuzzy: 1 term") {
+        return snap.find_fuzzy({names.data(), 1}, 5);
+    };
+
+    BENCHMARK("find_fuzzy: 10 terms") {
+        return snap.find_fuzzy(names, 5);
+    };
+
+    BENCHMARK("find_by_name: 1 term") {
+        return snap.find_by_name({names.data(), 1});
+    };
+}
+
+// Measures a full update from a CSV file of 50 000 records, read directly,
+// decompressed from gzip and through a local transfer.
+// Inserts 50 000 records into a new database.
+TEST_CASE("ConnRW::insert") {
+    const std::string db_path  = "testdata/bench_insert.db";
+    const std::string csv_path = "testdata/bench_insert.csv";
+
+    const std::array<std::string, 16> words = {
+        "Micro", "Net", "Tele", "Data", "Opto", "Smart", "Cloud", "Digi",
+        "Electro", "Info", "Power", "Sys", "Wave", "Link", "Tech", "Vision",
+    };
+
+    {
+        std::ofstream csv{csv_path};
+        csv << "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n";
+
+        for (size_t i = 0; i < 50'000; i++) {
+            const size_t h = i * 2654435761u;
+
+            csv << prefix_to_string(static_cast<int64_t>(i), 6) << ",\"" << words[h % 16] << words[h / 16 % 16] << words[h / 256 % 16]
+                << ", Inc\",false,MA-L,2015/11/17\n";
+        }
+    }
+
+    const auto update = [&](std::istream& is) {
+        std::filesystem::remove(db_path);
+
+        ConnRW conn_rw{db_path, true};
+
+        std::ostringstream warnings;
+        conn_rw.insert(is, true, warnings);
+    };
+
+    BENCHMARK("std::ifstream") {
+        std::ifstream is{csv_path};
+        update(is);
+    };
+
+    // Loads the file in bulk-load mode, width records per statement.
+    // The rollback journal and syncs are left enabled if width is 0.
+    const auto load = [&](const size_t width) {
+        std::filesystem::remove(db_path);
+
+        ConnRW conn_rw{db_path, true};
+
+        if (width > 0) {
+            conn_rw.begin_bulk_load(width);
+        }
+
+        std::ostringstream warnings;
+        conn_rw.insert(Reader{csv_path}.data(), true, warnings);
+    };
+
+    BENCHMARK("Reader::data") {
+        load(0);
+    };
+
+    BENCHMARK("Reader::data, bulk load: 1 record per statement") {
+        load(1);
+    };
+
+    BENCHMARK("Reader::data, bulk load: 16 records per statement") {
+        load(ConnRW::BULK_WIDTH);
+    };
+
+    BENCHMARK("Reader::data, bulk load: 64 records per statement") {
+        load(64);
+    };
+
+    BENCHMARK("Reader::data, bulk load: 256 records per statement") {
+        load(256);
+    };
+
+    const std::string url = "file://" + std::filesystem::absolute(csv_path).string();
+
+    BENCHMARK("Downloader") {
+        update(Downloader{url}.get());
+    };
+
+    const std::string gz_path = csv_path + ".gz";
+
+    {
+        const Reader csv{csv_path};
+
+        gzFile file = gzopen(gz_path.c_str(), "wb");
+        gzwrite(file, csv.data().data(), static_cast<unsigned>(csv.data().size()));
+        gzclose(file);
+    }
+
+    BENCHMARK("Decompressor: gzip") {
+        update(Decompressor{Reader{gz_path}}.get());
+    };
 }
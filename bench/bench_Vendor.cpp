@@ -1,10 +1,15 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <future>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Vendor.hpp"
+#include "utils.hpp"
 
-TEST_CASE("Benchmark Vendor::Vendor(std::string&)") {
+TEST_CASE("Benchmark Vendor::Vendor(std::string_view)") {
     BENCHMARK("quoted vendor name") {
         return Vendor(R"(00:00:0C,"Cisco Systems, Inc",false,MA-L,2015/11/17)");
     };
@@ -12,3 +17,65 @@ TEST_CASE("Benchmark Vendor::Vendor(std::string&)") {
         return Vendor(R"(00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17)");
     };
 }
+
+TEST_CASE("Benchmark VendorView::VendorView(std::string_view, std::string&)") {
+    std::string buf;
+
+    BENCHMARK("quoted vendor name") {
+        return VendorView(R"(00:00:0C,"Cisco Systems, Inc",false,MA-L,2015/11/17)", buf);
+    };
+    BENCHMARK("unquoted vendor name") {
+        return VendorView(R"(00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17)", buf);
+    };
+    BENCHMARK("escaped quotes") {
+        return VendorView(R"(2C:7A:FE,"IEE&E ""Black"" ops",false,MA-L,2010/07/26)", buf);
+    };
+}
+
+// Measures parse throughput over 50 000 CSV lines, as a single block
+// and split into one block per hardware thread, against parsing
+// the lines one by one.
+TEST_CASE("Benchmark VendorBlock::VendorBlock(std::string_view)") {
+    const std::array<std::string, 4> lines = {
+        R"(,"Cisco Systems, Inc",false,MA-L,2015/11/17)",
+        R"(,FIBRONICS LTD.,false,MA-L,2015/11/17)",
+        R"(,"IEE&E ""Black"" ops",false,MA-L,2010/07/26)",
+        R"(,,true,,0001/01/01)",
+    };
+
+    std::string csv;
+    for (int64_t i = 0; i < 50'000; i++) {
+        csv += prefix_to_string(i, 6) + lines[static_cast<size_t>(i) % lines.size()] + '\n';
+    }
+
+    const size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    BENCHMARK("line by line") {
+        std::vector<VendorView> rows;
+        std::string             buf;
+
+        for (size_t pos = 0, end; pos < csv.size(); pos = end + 1) {
+            end = std::min(csv.find('\n', pos), csv.size());
+            rows.emplace_back(std::string_view{csv}.substr(pos, end - pos), buf);
+        }
+        return rows.size();
+    };
+
+    BENCHMARK("1 block") {
+        return VendorBlock{csv}.rows.size();
+    };
+
+    BENCHMARK("1 block per thread") {
+        std::vector<std::future<VendorBlock>> blocks;
+
+        for (const auto block : split_lines(csv, threads)) {
+            blocks.push_back(std::async(std::launch::async, [block] { return VendorBlock{block}; }));
+        }
+
+        size_t rows = 0;
+        for (auto& b : blocks) {
+            rows += b.get().rows.size();
+        }
+        return rows;
+    };
+}
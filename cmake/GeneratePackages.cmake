@@ -40,13 +40,13 @@ set(CPACK_RESOURCE_FILE_LICENSE       "${PROJECT_SOURCE_DIR}/LICENSE"
 set(CPACK_RESOURCE_FILE_README        "${PROJECT_SOURCE_DIR}/README.md"         )
 
 set(CPACK_DEBIAN_PACKAGE_SECTION      "utils"                                   )
-set(CPACK_DEBIAN_PACKAGE_DEPENDS      "libcurl4, libsqlite3-0"                  )
+set(CPACK_DEBIAN_PACKAGE_DEPENDS      "libcurl4, libsqlite3-0, zlib1g, libzstd1")
 
 set(CPACK_RPM_PACKAGE_RELEASE         "1"                                       )
 set(CPACK_RPM_PACKAGE_DESCRIPTION     ${CPACK_PACKAGE_DESCRIPTION}              )
 set(CPACK_RPM_PACKAGE_GROUP           "Unspecified"                             )
 set(CPACK_RPM_PACKAGE_LICENSE         "MIT"                                     )
-set(CPACK_RPM_PACKAGE_REQUIRES        "libcurl, sqlite"                         )
+set(CPACK_RPM_PACKAGE_REQUIRES        "libcurl, sqlite, zlib, libzstd"          )
 
 set(CPACK_PACKAGE_INSTALL_DIRECTORY            "${PROJECT_NAME}"                )
 set(CPACK_NSIS_DISPLAY_NAME                    "${PROJECT_NAME}"                )
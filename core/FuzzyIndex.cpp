@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <utility>
+
+#include "FuzzyIndex.hpp"
+#include "exception.hpp"
+
+// Maps the characters kept by normalization (ASCII letters, digits and bytes
+// of non-ASCII UTF-8 characters) to themselves, folded to lower case,
+// and every other character to '\0'.
+static constexpr auto NORM = [] {
+    std::array<char, 256> table{};
+
+    for (size_t u = 0; u < table.size(); u++) {
+        if ((u >= 'a' && u <= 'z') || (u >= '0' && u <= '9') || u >= 0x80) {
+            table[u] = static_cast<char>(u);
+        } else if (u >= 'A' && u <= 'Z') {
+            table[u] = static_cast<char>(u - 'A' + 'a');
+        }
+    }
+
+    return table;
+}();
+
+// Returns the trigram at position i of s, packed into an integer.
+static uint32_t gram_at(const std::string_view s, const size_t i) noexcept {
+    return static_cast<uint32_t>(static_cast<unsigned char>(s[i])) << 16
+         | static_cast<uint32_t>(static_cast<unsigned char>(s[i + 1])) << 8
+         | static_cast<uint32_t>(static_cast<unsigned char>(s[i + 2]));
+}
+
+FuzzyIndex::FuzzyIndex(
+    const std::string_view          strings,
+    const std::span<const Name>     names,
+    const std::span<const uint32_t> keys,
+    const std::span<const uint32_t> offs,
+    const std::span<const uint32_t> postings
+) noexcept : strings{strings},
+             names{names},
+             keys{keys},
+             offs{offs},
+             postings{postings} {}
+
+FuzzyIndex::FuzzyIndex(const std::string_view strings, const Tables& tables) noexcept
+    : FuzzyIndex{strings, tables.names, tables.keys, tables.offs, tables.postings} {}
+
+FuzzyIndex::Tables FuzzyIndex::build(const std::string_view strings, std::vector<Name> names) {
+    // <trigram, name> pairs of every name
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+
+    for (size_t i = 0; i < names.size(); i++) {
+        const std::vector<uint32_t> grams = grams_of(normalize(strings.substr(names[i].off, names[i].len)));
+
+        names[i].grams = static_cast<uint32_t>(grams.size());
+
+        for (const uint32_t g : grams) {
+            pairs.emplace_back(g, static_cast<uint32_t>(i));
+        }
+    }
+
+    if (pairs.size() > UINT32_MAX) {
+        throw errors::Error{"name index size limit exceeded"};
+    }
+
+    std::ranges::sort(pairs);
+
+    Tables tables;
+    tables.names = std::move(names);
+    tables.postings.reserve(pairs.size());
+
+    for (const auto& [gram, name] : pairs) {
+        if (tables.keys.empty() || tables.keys.back() != gram) {
+            tables.keys.push_back(gram);
+            tables.offs.push_back(static_cast<uint32_t>(tables.postings.size()));
+        }
+        tables.postings.push_back(name);
+    }
+    tables.offs.push_back(static_cast<uint32_t>(tables.postings.size()));
+
+    return tables;
+}
+
+size_t FuzzyIndex::distance(const std::string_view term, const Masks& masks, const std::string_view text) {
+    // Normalizes text on the fly, passing every character to step.
+    const auto scan = [&text](auto&& step) {
+        bool gap = false;
+        bool any = false;
+
+        for (const char c : text) {
+            const char n = NORM[static_cast<unsigned char>(c)];
+
+            if (n == '\0') {
+                gap = any;
+                continue;
+            }
+
+            if (gap) {
+                step(' ');
+                gap = false;
+            }
+
+            step(n);
+            any = true;
+        }
+    };
+
+    size_t best = term.size();
+
+    if (term.empty()) {
+        return best;
+    }
+
+    if (term.size() <= 64) {
+        // Bit-parallel algorithm of Myers. Bit i of the vectors holds
+        // the vertical delta in row i + 1 of the current column.
+        const uint64_t high = uint64_t{1} << (term.size() - 1);
+
+        uint64_t pv    = ~uint64_t{0};
+        uint64_t mv    = 0;
+        size_t   score = term.size();
+
+        scan([&](const char c) {
+            const uint64_t eq = masks[static_cast<unsigned char>(c)];
+            const uint64_t xv = eq | mv;
+            const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            if (ph & high) {
+                score++;
+            } else if (mh & high) {
+                score--;
+            }
+
+            // Row 0 stays 0, since the match may begin anywhere in text
+            ph <<= 1;
+            mh <<= 1;
+
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            best = std::min(best, score);
+        });
+
+        return best;
+    }
+
+    // Column of the edit distance matrix. Row 0 stays 0, since the match
+    // may begin anywhere in text.
+    std::vector<size_t> col(term.size() + 1);
+
+    for (size_t i = 0; i < col.size(); i++) {
+        col[i] = i;
+    }
+
+    scan([&](const char c) {
+        size_t diag = 0;
+
+        for (size_t i = 1; i < col.size(); i++) {
+            const size_t subst = diag + (term[i - 1] == c ? 0 : 1);
+
+            diag   = col[i];
+            col[i] = std::min({subst, col[i] + 1, col[i - 1] + 1});
+        }
+
+        best = std::min(best, col.back());
+    });
+
+    return best;
+}
+
+std::vector<uint32_t> FuzzyIndex::find(const std::string_view term, const size_t top) const {
+    struct Candidate {
+        uint32_t         name;
+        uint32_t         shared;
+        size_t           distance;
+        std::string_view text;
+    };
+
+    const std::string norm = normalize(term);
+
+    if (norm.empty() || top == 0) {
+        return {};
+    }
+
+    const std::vector<uint32_t> grams = grams_of(norm);
+
+    Masks masks{};
+    for (size_t i = 0; i < norm.size() && i < 64; i++) {
+        masks[static_cast<unsigned char>(norm[i])] |= uint64_t{1} << i;
+    }
+
+    // Every edit destroys at most 3 trigrams of the term and the 2 padded
+    // ones are lost if the match does not begin and end at word boundaries.
+    // Thus a name within distance d shares at least grams - 3 * d - 2
+    // trigrams with the term.
+    const size_t limit      = std::min(MAX_DISTANCE, norm.size() / 4);
+    const size_t min_shared = (grams.size() > 3 * limit + 2) ? grams.size() - 3 * limit - 2 : 1;
+
+    if (offs.size() != keys.size() + 1) {
+        throw errors::CacheError{"name index is corrupted"};
+    }
+
+    // Returns the names containing trigram g
+    const auto postings_of = [&](const uint32_t g) -> std::span<const uint32_t> {
+        const auto it = std::ranges::lower_bound(keys, g);
+
+        if (it == keys.end() || *it != g) {
+            return {};
+        }
+
+        const auto k = static_cast<size_t>(it - keys.begin());
+
+        if (offs[k] > offs[k + 1] || offs[k + 1] > postings.size()) {
+            throw errors::CacheError{"name index is corrupted"};
+        }
+
+        return postings.subspan(offs[k], offs[k + 1] - offs[k]);
+    };
+
+    // Number of trigrams shared with the term, by name
+    std::vector<uint32_t> shared(names.size());
+    std::vector<uint32_t> touched;
+
+    for (const uint32_t g : grams) {
+        for (const uint32_t n : postings_of(g)) {
+            if (n >= names.size()) {
+                throw errors::CacheError{"name index is corrupted"};
+            }
+
+            if (shared[n]++ == 0) {
+                touched.push_back(n);
+            }
+        }
+    }
+
+    // If the term is split into limit + 1 pieces, a name within limit
+    // contains at least one of them unchanged, and every trigram of that
+    // piece. Names containing no piece are not verified. Pieces shorter
+    // than a trigram disable the filter.
+    std::vector<bool> eligible;
+
+    if (norm.size() / (limit + 1) >= 3) {
+        eligible.resize(names.size());
+
+        for (size_t p = 0; p <= limit; p++) {
+            const size_t first = norm.size() * p / (limit + 1);
+            const size_t last  = norm.size() * (p + 1) / (limit + 1);
+
+            const std::span<const uint32_t> head = postings_of(gram_at(norm, first));
+
+            std::vector<uint32_t> common{head.begin(), head.end()};
+            std::vector<uint32_t> next;
+
+            for (size_t i = first + 1; i + 3 <= last && !common.empty(); i++) {
+                next.clear();
+                std::ranges::set_intersection(common, postings_of(gram_at(norm, i)), std::back_inserter(next));
+                common.swap(next);
+            }
+
+            for (const uint32_t n : common) {
+                eligible[n] = true;
+            }
+        }
+    }
+
+    // Names sorted by the number of shared trigrams, descending,
+    // with a counting sort. Names in level l share grams.size() - l.
+    std::vector<uint32_t> levels(grams.size() + 2);
+
+    for (const uint32_t n : touched) {
+        if (shared[n] >= min_shared) {
+            levels[grams.size() - shared[n] + 1]++;
+        }
+    }
+
+    for (size_t l = 1; l < levels.size(); l++) {
+        levels[l] += levels[l - 1];
+    }
+
+    std::vector<uint32_t> sorted(levels.back());
+    std::vector<uint32_t> next(levels.begin(), levels.end() - 1);
+
+    for (const uint32_t n : touched) {
+        if (shared[n] >= min_shared) {
+            sorted[next[grams.size() - shared[n]]++] = n;
+        }
+    }
+
+    std::vector<Candidate> candidates;
+
+    // Number of candidates found at each distance
+    std::vector<size_t> found(limit + 1);
+
+    for (size_t l = 0; l + 1 < levels.size(); l++) {
+        // Lower bound of the distance of names in this level,
+        // ceil((l - 2) / 3) by the bound above
+        const size_t bound = l / 3;
+
+        // Distance of the top-th candidate found so far, or limit
+        // if fewer were found. Names further away cannot be reported.
+        size_t worst    = 0;
+        size_t reported = 0;
+
+        for (; worst < limit; worst++) {
+            if ((reported += found[worst]) >= top) {
+                break;
+            }
+        }
+
+        if (bound > worst) {
+            break;
+        }
+
+        for (size_t i = levels[l]; i < levels[l + 1]; i++) {
+            const uint32_t n = sorted[i];
+
+            if (!eligible.empty() && !eligible[n]) {
+                continue;
+            }
+
+            const Name& name = names[n];
+
+            if (name.off > strings.size() || name.len > strings.size() - name.off) {
+                throw errors::CacheError{"name index is corrupted"};
+            }
+
+            const std::string_view text = strings.substr(name.off, name.len);
+
+            if (const size_t d = distance(norm, masks, text); d <= limit) {
+                candidates.push_back({n, shared[n], d, text});
+                found[d]++;
+            }
+        }
+    }
+
+    // Trigram similarity of two candidates is compared as the ratio
+    // of shared trigrams to the trigrams of either string.
+    const auto better = [&](const Candidate& a, const Candidate& b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+
+        const uint64_t a_union = grams.size() + names[a.name].grams - a.shared;
+        const uint64_t b_union = grams.size() + names[b.name].grams - b.shared;
+
+        if (a.shared * b_union != b.shared * a_union) {
+            return a.shared * b_union > b.shared * a_union;
+        }
+
+        return std::pair{a.text, a.name} < std::pair{b.text, b.name};
+    };
+
+    const size_t n = std::min(top, candidates.size());
+
+    std::ranges::partial_sort(candidates, candidates.begin() + static_cast<std::ptrdiff_t>(n), better);
+
+    std::vector<uint32_t> results;
+    results.reserve(n);
+
+    for (size_t i = 0; i < n; i++) {
+        results.push_back(candidates[i].name);
+    }
+
+    return results;
+}
+
+std::vector<uint32_t> FuzzyIndex::grams_of(const std::string_view s) {
+    const std::string padded = ' ' + std::string{s} + ' ';
+
+    std::vector<uint32_t> grams;
+
+    for (size_t i = 0; i + 3 <= padded.size(); i++) {
+        grams.push_back(gram_at(padded, i));
+    }
+
+    std::ranges::sort(grams);
+
+    const auto [first, last] = std::ranges::unique(grams);
+    grams.erase(first, last);
+
+    return grams;
+}
+
+std::string FuzzyIndex::normalize(const std::string_view s) {
+    std::string norm;
+    norm.reserve(s.size());
+
+    // Signals whether a separator follows the last character
+    bool gap = false;
+
+    for (const char c : s) {
+        const char n = NORM[static_cast<unsigned char>(c)];
+
+        if (n == '\0') {
+            gap = !norm.empty();
+            continue;
+        }
+
+        if (gap) {
+            norm += ' ';
+            gap = false;
+        }
+
+        norm += n;
+    }
+
+    return norm;
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <queue>
+
+#include "NameMatcher.hpp"
+#include "utils.hpp"
+
+NameMatcher::NameMatcher(std::span<const std::string> terms) : n_classes{1} {
+    const auto fold = [](const char c) -> unsigned char {
+        return static_cast<unsigned char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+    };
+
+    const auto is_plain = [](const std::string& term) {
+        return term.find_first_of("%_\\") == std::string::npos;
+    };
+
+    classes.fill(0);
+
+    for (const auto& t : terms) {
+        if (is_plain(t)) {
+            for (const char c : t) {
+                if (uint32_t& cls = classes[fold(c)]; cls == 0) {
+                    cls = n_classes++;
+                }
+            }
+        }
+    }
+
+    for (unsigned char c = 'A'; c <= 'Z'; c++) {
+        classes[c] = classes[fold(static_cast<char>(c))];
+    }
+
+    // Terms ending in each state of the trie
+    std::vector<std::vector<uint32_t>> own(1);
+
+    // Transitions of the trie. Since no transition leads back to the root,
+    // 0 marks a missing one.
+    delta.assign(n_classes, 0);
+
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (!is_plain(terms[i])) {
+            patterns.emplace_back(static_cast<uint32_t>(i), '%' + terms[i] + '%');
+            continue;
+        }
+
+        uint32_t s = 0;
+
+        for (const char c : terms[i]) {
+            const size_t t = size_t{s} * n_classes + classes[static_cast<unsigned char>(c)];
+
+            if (delta[t] == 0) {
+                delta[t] = static_cast<uint32_t>(own.size());
+                delta.resize(delta.size() + n_classes, 0);
+                own.emplace_back();
+            }
+            s = delta[t];
+        }
+
+        own[s].push_back(static_cast<uint32_t>(i));
+    }
+
+    // Breadth-first traversal computes failure links and completes missing
+    // transitions with those of the failure state, which is always shallower
+    // and therefore already complete.
+    std::vector<uint32_t> fail(own.size(), 0);
+    std::vector<uint32_t> order;
+    order.reserve(own.size());
+
+    std::queue<uint32_t> queue;
+    queue.push(0);
+
+    while (!queue.empty()) {
+        const uint32_t s = queue.front();
+        queue.pop();
+        order.push_back(s);
+
+        for (uint32_t k = 0; k < n_classes; k++) {
+            uint32_t& next = delta[size_t{s} * n_classes + k];
+
+            if (next != 0) {
+                fail[next] = (s == 0) ? 0 : delta[size_t{fail[s]} * n_classes + k];
+                queue.push(next);
+            } else if (s != 0) {
+                next = delta[size_t{fail[s]} * n_classes + k];
+            }
+        }
+    }
+
+    // Terms recognized by the failure state are recognized as well.
+    // Failure states precede their dependents in order.
+    for (const uint32_t s : order) {
+        if (s != 0) {
+            own[s].insert(own[s].end(), own[fail[s]].begin(), own[fail[s]].end());
+        }
+    }
+
+    out_offs.reserve(own.size() + 1);
+
+    for (auto& o : own) {
+        out_offs.push_back(static_cast<uint32_t>(out_terms.size()));
+        out_terms.insert(out_terms.end(), o.begin(), o.end());
+    }
+    out_offs.push_back(static_cast<uint32_t>(out_terms.size()));
+}
+
+bool NameMatcher::matches(const std::string_view name) const {
+    uint32_t s = 0;
+
+    for (const char c : name) {
+        s = delta[size_t{s} * n_classes + classes[static_cast<unsigned char>(c)]];
+
+        if (out_offs[s] != out_offs[s + 1]) {
+            return true;
+        }
+    }
+
+    return std::ranges::any_of(patterns, [&name](const auto& p) {
+        return like_match(name, p.second);
+    });
+}
+
+std::vector<uint32_t> NameMatcher::match(const std::string_view name) const {
+    std::vector<uint32_t> ids;
+
+    uint32_t s = 0;
+
+    for (const char c : name) {
+        s = delta[size_t{s} * n_classes + classes[static_cast<unsigned char>(c)]];
+        ids.insert(ids.end(), out_terms.begin() + out_offs[s], out_terms.begin() + out_offs[s + 1]);
+    }
+
+    for (const auto& [id, pattern] : patterns) {
+        if (like_match(name, pattern)) {
+            ids.push_back(id);
+        }
+    }
+
+    std::ranges::sort(ids);
+
+    const auto [first, last] = std::ranges::unique(ids);
+    ids.erase(first, last);
+
+    return ids;
+}
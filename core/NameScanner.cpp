@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCANNER_SSE2
+#endif
+
+#include "NameScanner.hpp"
+#include "utils.hpp"
+
+// Folds ASCII letters to lower case, like SQLite's LIKE operator.
+static char fold(const char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+NameScanner::NameScanner(std::span<const std::string_view> names, size_t threads) {
+    // Smallest chunk worth handing to a separate thread
+    constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+    offs.reserve(names.size() + 1);
+
+    for (const auto& n : names) {
+        offs.push_back(static_cast<uint32_t>(this->names.size()));
+
+        this->names += n;
+        this->names += '\0';
+    }
+    offs.push_back(static_cast<uint32_t>(this->names.size()));
+
+    folded.resize(this->names.size());
+    std::ranges::transform(this->names, folded.begin(), fold);
+
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads = std::clamp(folded.size() / MIN_CHUNK_SIZE, size_t{1}, threads);
+
+    chunks.push_back(0);
+    for (size_t c = 1; c < threads; c++) {
+        const auto it = std::ranges::lower_bound(offs, folded.size() * c / threads);
+        chunks.push_back(static_cast<uint32_t>(it - offs.begin()));
+    }
+    chunks.push_back(static_cast<uint32_t>(names.size()));
+}
+
+struct NameScanner::Term {
+    // '%' + term + '%'
+    std::string pattern;
+
+    // Longest literal run of the term, folded
+    std::string needle;
+
+    // Set if the term contains no wildcards or escapes
+    bool plain;
+};
+
+std::vector<NameScanner::Term> NameScanner::parse_terms(std::span<const std::string> terms) {
+    std::vector<Term> parsed;
+    parsed.reserve(terms.size());
+
+    for (const auto& t : terms) {
+        std::string needle;
+        for (auto& run : like_literals(t)) {
+            if (run.size() > needle.size()) {
+                needle = std::move(run);
+            }
+        }
+
+        std::ranges::transform(needle, needle.begin(), fold);
+
+        const bool plain = t.find_first_of("%_\\") == std::string::npos;
+
+        parsed.push_back(Term{'%' + t + '%', std::move(needle), plain});
+    }
+
+    return parsed;
+}
+
+void NameScanner::scan_chunks(const std::function<void(size_t)>& scan) const {
+    std::vector<std::future<void>> workers;
+    for (size_t c = 1; c + 1 < chunks.size(); c++) {
+        workers.push_back(std::async(std::launch::async, scan, c));
+    }
+
+    scan(0);
+
+    for (auto& w : workers) {
+        w.get();
+    }
+}
+
+std::vector<uint32_t> NameScanner::find(std::span<const std::string> terms) const {
+    const std::vector<Term> parsed = parse_terms(terms);
+
+    // Matching positions, by chunk
+    std::vector<std::vector<uint32_t>> matches(chunks.size() - 1);
+
+    std::optional<NameMatcher> matcher;
+    if (terms.size() >= MIN_MATCHER_TERMS) {
+        matcher.emplace(terms);
+    }
+
+    scan_chunks([&](const size_t c) {
+        if (matcher) {
+            scan_chunk(c, *matcher, matches[c]);
+            return;
+        }
+
+        for (const auto& t : parsed) {
+            scan_chunk(c, t.pattern, t.needle, t.plain, matches[c]);
+        }
+    });
+
+    std::vector<uint32_t> found;
+
+    for (auto& m : matches) {
+        // A name matched by several terms is found once per term
+        std::ranges::sort(m);
+        const auto [first, last] = std::ranges::unique(m);
+        found.insert(found.end(), m.begin(), first);
+    }
+
+    return found;
+}
+
+std::vector<std::vector<uint32_t>> NameScanner::find_each(std::span<const std::string> terms) const {
+    const std::vector<Term> parsed = parse_terms(terms);
+
+    // Matching positions, by chunk and term
+    std::vector<std::vector<std::vector<uint32_t>>> matches(chunks.size() - 1, std::vector<std::vector<uint32_t>>(terms.size()));
+
+    std::optional<NameMatcher> matcher;
+    if (terms.size() >= MIN_MATCHER_TERMS) {
+        matcher.emplace(terms);
+    }
+
+    scan_chunks([&](const size_t c) {
+        if (matcher) {
+            scan_chunk(c, *matcher, matches[c]);
+            return;
+        }
+
+        for (size_t t = 0; t < parsed.size(); t++) {
+            scan_chunk(c, parsed[t].pattern, parsed[t].needle, parsed[t].plain, matches[c][t]);
+        }
+    });
+
+    // Chunks follow each other, so their positions are concatenated in order
+    std::vector<std::vector<uint32_t>> found(terms.size());
+
+    for (const auto& m : matches) {
+        for (size_t t = 0; t < terms.size(); t++) {
+            found[t].insert(found[t].end(), m[t].begin(), m[t].end());
+        }
+    }
+
+    return found;
+}
+
+size_t NameScanner::find_folded(const std::string_view haystack, const std::string_view needle, size_t pos) noexcept {
+    const size_t n = needle.size();
+
+#if defined(SCANNER_SSE2)
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last  = _mm_set1_epi8(needle.back());
+
+    for (; pos + n - 1 + 16 <= haystack.size(); pos += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + pos));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + pos + n - 1));
+
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+
+        while (mask != 0) {
+            const size_t p = pos + static_cast<size_t>(std::countr_zero(mask));
+
+            if (n <= 2 || std::memcmp(haystack.data() + p + 1, needle.data() + 1, n - 2) == 0) {
+                return p;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    return haystack.find(needle, pos);
+}
+
+std::string_view NameScanner::name(const size_t i) const noexcept {
+    return {names.data() + offs[i], offs[i + 1] - offs[i] - 1};
+}
+
+void NameScanner::scan_chunk(const size_t c, const std::string& pattern, const std::string_view needle, const bool plain, std::vector<uint32_t>& found) const {
+    const size_t first = chunks[c];
+    const size_t last  = chunks[c + 1];
+
+    // Without a literal run, every name is a candidate. Empty names
+    // are stored as NULL in the database and never match.
+    if (needle.empty()) {
+        for (size_t i = first; i < last; i++) {
+            const std::string_view n = name(i);
+
+            if (!n.empty() && like_match(n, pattern)) {
+                found.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        return;
+    }
+
+    const std::string_view haystack{folded.data(), offs[last]};
+
+    size_t pos = offs[first];
+
+    while ((pos = find_folded(haystack, needle, pos)) != std::string_view::npos) {
+        // Name that contains the match
+        const auto   it = std::ranges::upper_bound(offs.begin() + static_cast<std::ptrdiff_t>(first), offs.begin() + static_cast<std::ptrdiff_t>(last), pos);
+        const size_t i  = static_cast<size_t>(it - offs.begin()) - 1;
+
+        if (plain || like_match(name(i), pattern)) {
+            found.push_back(static_cast<uint32_t>(i));
+        }
+
+        // Skip the rest of the name
+        pos = offs[i + 1];
+    }
+}
+
+void NameScanner::scan_chunk(const size_t c, const NameMatcher& matcher, std::vector<uint32_t>& found) const {
+    for (size_t i = chunks[c]; i < chunks[c + 1]; i++) {
+        const std::string_view n = name(i);
+
+        if (!n.empty() && matcher.matches(n)) {
+            found.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void NameScanner::scan_chunk(const size_t c, const NameMatcher& matcher, std::vector<std::vector<uint32_t>>& found) const {
+    for (size_t i = chunks[c]; i < chunks[c + 1]; i++) {
+        const std::string_view n = name(i);
+
+        if (n.empty()) {
+            continue;
+        }
+
+        for (const uint32_t t : matcher.match(n)) {
+            found[t].push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+size_t NameScanner::size() const noexcept {
+    return offs.size() - 1;
+}
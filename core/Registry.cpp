@@ -13,7 +13,7 @@ std::string from_registry(const Registry registry) noexcept {
     }
 }
 
-Registry to_registry(const std::string& registry) noexcept {
+Registry to_registry(const std::string_view registry) noexcept {
     using enum Registry;
 
     if (registry == "MA-L") {
@@ -1,55 +1,355 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VENDOR_SSE2
+#endif
 
 #include "Vendor.hpp"
 #include "exception.hpp"
 #include "out.hpp"
 #include "utils.hpp"
 
-Vendor::Vendor(const std::string& line) {
-    constexpr char        COMMA = ',';
-    constexpr char        QUOTE = '"';
-    constexpr const char* ESCQT = "\"\""; // Escaped double quote
-    constexpr const char* QTCOM = "\",";  // Termination of quoted CSV field
+// Offsets of the commas, double quotes and newlines (marks) in a block
+// of CSV data, stored as a bitmap and read in ascending order. Bit i
+// of word w stands for byte 64 * w + i of the block.
+class CsvMarks {
+    std::vector<uint64_t> bits;
+
+    // Size of the block.
+    size_t size;
+
+    // Number of newlines in the block.
+    size_t newlines;
+
+    // Index of the word holding the next mark.
+    size_t w;
+
+    // Marks of word w that have not been read yet.
+    uint64_t word;
+
+public:
+    // Classifies the bytes of csv, 64 at a time.
+    explicit CsvMarks(const std::string_view csv) : bits((csv.size() + 63) / 64), size{csv.size()}, newlines{0}, w{0}, word{0} {
+        size_t pos = 0;
+
+#if defined(VENDOR_SSE2)
+        const __m128i comma   = _mm_set1_epi8(',');
+        const __m128i quote   = _mm_set1_epi8('"');
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        for (; pos + 64 <= csv.size(); pos += 64) {
+            uint64_t m = 0;
+            uint64_t n = 0;
+
+            for (int i = 0; i < 4; i++) {
+                const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(csv.data() + pos + 16 * i));
+                const __m128i nl = _mm_cmpeq_epi8(v, newline);
+                const __m128i mk = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)), nl);
+
+                m |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(mk))} << (16 * i);
+                n |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(nl))} << (16 * i);
+            }
+
+            bits[pos / 64] = m;
+            newlines += static_cast<size_t>(std::popcount(n));
+        }
+#endif
+
+        for (; pos < csv.size(); pos++) {
+            if (csv[pos] == '\n') {
+                newlines++;
+            } else if (csv[pos] != ',' && csv[pos] != '"') {
+                continue;
+            }
+            bits[pos / 64] |= uint64_t{1} << (pos % 64);
+        }
+
+        if (!bits.empty()) {
+            word = bits[0];
+        }
+    }
+
+    // Returns the number of newlines in the block.
+    size_t count_newlines() const noexcept {
+        return newlines;
+    }
+
+    // Returns the offset of the next mark, or the size of the block
+    // once all marks have been read.
+    size_t next() noexcept {
+        while (word == 0) {
+            if (++w >= bits.size()) {
+                w = bits.size();
+                return size;
+            }
+            word = bits[w];
+        }
+
+        const size_t m = 64 * w + static_cast<size_t>(std::countr_zero(word));
+        word &= word - 1;
+
+        return m;
+    }
+};
+
+// Splits the CSV line starting at p1 into fields at its marks, read
+// from marks, following the rules of VendorView::VendorView. All marks
+// of the line are read, along with the newline that ends it, and its end
+// is stored in end. A vendor name with escaped quotes is unescaped into
+// buf. Returns std::nullopt if the line is malformed, leaving it
+// to VendorView to report the error.
+static std::optional<VendorView> split_marked(const std::string_view csv, size_t p1, CsvMarks& marks, size_t& end, std::string& buf) {
+    size_t m;
+
+    // Returns true if offset p ends the line
+    const auto ends_line = [&](const size_t p) {
+        return p >= csv.size() || csv[p] == '\n';
+    };
+
+    // Reads marks up to the first comma at or past p. Returns false
+    // if the line ends before, storing the end.
+    const auto seek_comma = [&](const size_t p) {
+        for (m = marks.next(); !ends_line(m); m = marks.next()) {
+            if (m >= p && csv[m] == ',') {
+                return true;
+            }
+        }
+        end = m;
+        return false;
+    };
+
+    // Reads the remaining marks of the line
+    const auto skip_line = [&] {
+        for (m = marks.next(); !ends_line(m); m = marks.next()) {}
+        end = m;
+    };
+
+    if (!seek_comma(p1)) {
+        return std::nullopt;
+    }
+
+    size_t p2 = m;
+
+    // Hex digits of the prefix, with colons skipped
+    int64_t mac_prefix = 0;
+    size_t  digits     = 0;
+
+    for (const char c : csv.substr(p1, p2 - p1)) {
+        int64_t nibble;
+
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c == ':') {
+            continue;
+        } else {
+            // Left to VendorView, which reports the error of prefix_to_int
+            digits = MAC_NIBBLES + 1;
+            break;
+        }
+
+        mac_prefix = mac_prefix << 4 | nibble;
+        digits++;
+    }
+
+    if (digits == 0 || digits > MAC_NIBBLES) {
+        skip_line();
+        return std::nullopt;
+    }
+
+    std::string_view vendor_name;
+
+    p1 = p2 + 1;
+    if (ends_line(p1)) {
+        skip_line();
+        return std::nullopt;
+    }
+
+    if (csv[p1] == '"') {
+        // Opening quote
+        marks.next();
+
+        // The name ends at the first '",' sequence. Quotes before it
+        // are part of the name.
+        bool quoted = false;
+
+        for (p2 = marks.next(); !ends_line(p2); p2 = marks.next()) {
+            if (csv[p2] == '"') {
+                if (p2 + 1 < csv.size() && csv[p2 + 1] == ',') {
+                    break;
+                }
+                quoted = true;
+            }
+        }
+
+        if (ends_line(p2)) {
+            end = p2;
+            return std::nullopt;
+        }
+
+        // Comma after the closing quote
+        marks.next();
+
+        vendor_name = csv.substr(p1 + 1, p2 - p1 - 1);
+        if (quoted && vendor_name.find("\"\"") != std::string_view::npos) {
+            buf = vendor_name;
+            replace_escaped_quotes(buf);
+            vendor_name = buf;
+        }
+        p1 = p2 + 2;
+    } else if (csv[p1] == ',') {
+        marks.next();
+        p1++;
+    } else {
+        if (!seek_comma(p1 + 1)) {
+            return std::nullopt;
+        }
+        vendor_name = csv.substr(p1, m - p1);
+        p1          = m + 1;
+    }
+
+    if (ends_line(p1)) {
+        skip_line();
+        return std::nullopt;
+    }
+
+    if (csv[p1] == 't') {
+        skip_line();
+        return VendorView{mac_prefix, static_cast<uint8_t>(digits), vendor_name, true, Registry::Unknown, {}};
+    } else if (csv[p1] != 'f') {
+        skip_line();
+        return std::nullopt;
+    }
+
+    // The comma past 'alse' must be the first one found
+    p1 += 5;
+    if (!seek_comma(p1)) {
+        return std::nullopt;
+    }
+    if (m != p1) {
+        skip_line();
+        return std::nullopt;
+    }
+    p1++;
+
+    if (!seek_comma(p1)) {
+        return std::nullopt;
+    }
+    p2 = m;
+
+    skip_line();
+
+    return VendorView{
+        mac_prefix,
+        static_cast<uint8_t>(digits),
+        vendor_name,
+        false,
+        to_registry(csv.substr(p1, p2 - p1)),
+        csv.substr(p2 + 1, end - p2 - 1),
+    };
+}
+
+Vendor::Vendor(const std::string_view line) {
+    std::string buf;
+    *this = Vendor{VendorView{line, buf}};
+}
+
+Vendor::Vendor(const VendorView& v)
+    : mac_prefix{v.mac_prefix},
+      prefix_len{v.prefix_len},
+      vendor_name{v.vendor_name},
+      is_private{v.is_private},
+      block_type{v.block_type},
+      last_update{v.last_update} {}
+
+int64_t VendorView::hash() const noexcept {
+    constexpr uint64_t OFFSET_BASIS = 0xCBF29CE484222325;
+    constexpr uint64_t PRIME        = 0x100000001B3;
+
+    uint64_t h = OFFSET_BASIS;
+
+    const auto add = [&](const unsigned char byte) {
+        h = (h ^ byte) * PRIME;
+    };
+
+    // Fields are separated by a byte that does not occur in them
+    for (const char c : vendor_name) {
+        add(static_cast<unsigned char>(c));
+    }
+    add(0);
+    add(is_private);
+    add(static_cast<unsigned char>(block_type));
+    for (const char c : last_update) {
+        add(static_cast<unsigned char>(c));
+    }
+
+    return static_cast<int64_t>(h);
+}
+
+VendorView::VendorView(const std::string_view line, std::string& buf) {
+    constexpr char             COMMA = ',';
+    constexpr char             QUOTE = '"';
+    constexpr std::string_view ESCQT = "\"\""; // Escaped double quote
+    constexpr std::string_view QTCOM = "\",";  // Termination of quoted CSV field
 
     // In this constructor, p1 typically points to the first element of interest
     // (opening quote, the beginning of a CSV field), while p2 points to its
     // terminating counterpart (closing quote, comma at the end of the field).
     size_t p1, p2;
 
-    if ((p1 = line.find(COMMA, 0)) == std::string::npos) {
-        throw errors::NoCommaError{line};
+    if ((p1 = line.find(COMMA, 0)) == std::string_view::npos) {
+        throw errors::NoCommaError{std::string{line}};
     }
-    mac_prefix = prefix_to_int(line.substr(0, p1));
+    const std::string_view prefix = line.substr(0, p1);
+
+    mac_prefix = prefix_to_int(prefix);
+
+    const size_t digits = prefix.size() - static_cast<size_t>(std::ranges::count(prefix, ':'));
+    if (digits > MAC_NIBBLES) {
+        throw errors::PrefixLengthError{std::string{line}};
+    }
+    prefix_len = static_cast<uint8_t>(digits);
     p1++;
 
     if (p1 >= line.length()) {
-        throw errors::PrefixTermError{line};
+        throw errors::PrefixTermError{std::string{line}};
     }
 
     if (line[p1] == QUOTE) {
         // Quoted vendor name (,"Cisco Systems, Inc",)
 
         // Find the vendor name field closure past the second escaped quote
-        if ((p2 = line.find(QTCOM, p1 + 1)) == std::string::npos) {
-            throw errors::QuotedTermSeqError{line};
+        if ((p2 = line.find(QTCOM, p1 + 1)) == std::string_view::npos) {
+            throw errors::QuotedTermSeqError{std::string{line}};
         }
 
-        // Assign substring to vendor name and replace escaped quotes
-        // with single quotes
+        // View the name between the quotes. Only a name with escaped quotes
+        // is copied, to replace them with single quotes.
         vendor_name = line.substr(p1 + 1, p2 - p1 - 1);
-        if (vendor_name.find(ESCQT) != std::string::npos) {
-            replace_escaped_quotes(vendor_name);
+        if (vendor_name.find(ESCQT) != std::string_view::npos) {
+            buf = vendor_name;
+            replace_escaped_quotes(buf);
+            vendor_name = buf;
         }
         p1 = p2 + 2;
     } else if (line[p1] == COMMA) {
         // Private block always has an empty vendor name - skip a comma
         // to reach private designator field.
-        vendor_name = "";
+        vendor_name = {};
         p1++;
     } else {
         // Unquoted vendor name
-        if ((p2 = line.find(COMMA, p1 + 1)) == std::string::npos) {
-            throw errors::UnquotedTermError{line};
+        if ((p2 = line.find(COMMA, p1 + 1)) == std::string_view::npos) {
+            throw errors::UnquotedTermError{std::string{line}};
         }
         vendor_name = line.substr(p1, p2 - p1);
         p1          = p2 + 1;
@@ -57,39 +357,63 @@ Vendor::Vendor(const std::string& line) {
 
     if (p1 >= line.length()) {
         // Private field is empty (comma after vendor name ends the line).
-        throw errors::PrivateInvalidError{line};
+        throw errors::PrivateInvalidError{std::string{line}};
     }
 
     if (line[p1] == 't') {
         // Private entry contains no more meaningful information
         is_private  = true;
         block_type  = Registry::Unknown;
-        last_update = "";
+        last_update = {};
         return;
     } else if (line[p1] != 'f') {
         // Private designator field must contain either 'true' or 'false'
-        throw errors::PrivateInvalidError{line};
+        throw errors::PrivateInvalidError{std::string{line}};
     }
     is_private = false;
 
     // Skip past 'alse,' to the next field
     p1 += 5;
     if (p1 >= line.length() || line[p1] != COMMA) {
-        throw errors::PrivateTermError{line};
+        throw errors::PrivateTermError{std::string{line}};
     }
     p1++;
 
     // Find the last comma
-    if ((p2 = line.find(COMMA, p1)) == std::string::npos) {
-        throw errors::BlockTypeTermError{line};
+    if ((p2 = line.find(COMMA, p1)) == std::string_view::npos) {
+        throw errors::BlockTypeTermError{std::string{line}};
     }
 
     block_type  = to_registry(line.substr(p1, p2 - p1));
     last_update = line.substr(p2 + 1);
 }
 
+VendorBlock::VendorBlock(const std::string_view csv) {
+    CsvMarks marks{csv};
+
+    rows.reserve(marks.count_newlines() + 1);
+
+    std::string buf;
+
+    for (size_t pos = 0, end; pos < csv.size(); pos = end + 1) {
+        if (auto v = split_marked(csv, pos, marks, end, buf)) {
+            rows.push_back(*v);
+        } else if (end > pos) {
+            rows.emplace_back(csv.substr(pos, end - pos), buf);
+        } else {
+            continue;
+        }
+
+        // Only names with escaped quotes are stored in buf
+        if (!buf.empty()) {
+            rows.back().vendor_name = unescaped.emplace_back(std::move(buf));
+            buf.clear();
+        }
+    }
+}
+
 std::ostream& Vendor::write_string_csv(std::ostream& os) const noexcept {
-    os << prefix_to_string(mac_prefix) << ',';
+    os << prefix_to_string(mac_prefix, prefix_len) << ',';
 
     if (has_spec_chars<out::Format::CSV>(vendor_name)) {
         os << '"' << escape_spec_chars<out::Format::CSV>(vendor_name) << "\",";
@@ -109,7 +433,7 @@ std::ostream& Vendor::write_string_csv(std::ostream& os) const noexcept {
 }
 
 std::ostream& Vendor::write_string_json(std::ostream& os) const noexcept {
-    os << R"({"macPrefix":")" << prefix_to_string(mac_prefix)
+    os << R"({"macPrefix":")" << prefix_to_string(mac_prefix, prefix_len)
        << R"(","vendorName":")";
 
     if (has_spec_chars<out::Format::JSON>(vendor_name)) {
@@ -128,7 +452,7 @@ std::ostream& Vendor::write_string_json(std::ostream& os) const noexcept {
 }
 
 std::ostream& Vendor::write_string_regular(std::ostream& os) const noexcept {
-    return os << "MAC prefix   " << prefix_to_string(mac_prefix) << '\n'
+    return os << "MAC prefix   " << prefix_to_string(mac_prefix, prefix_len) << '\n'
               << "Vendor name  " << (vendor_name.empty() ? "-" : vendor_name) << '\n'
               << "Private      " << (is_private ? "yes" : "no") << '\n'
               << "Block type   " << from_registry(block_type) << '\n'
@@ -136,7 +460,7 @@ std::ostream& Vendor::write_string_regular(std::ostream& os) const noexcept {
 }
 
 std::ostream& Vendor::write_string_xml(std::ostream& os) const noexcept {
-    os << R"(<VendorMapping mac_prefix=")" << prefix_to_string(mac_prefix)
+    os << R"(<VendorMapping mac_prefix=")" << prefix_to_string(mac_prefix, prefix_len)
        << R"(" vendor_name=")";
 
     if (vendor_name.empty()) {
@@ -151,7 +475,7 @@ std::ostream& Vendor::write_string_xml(std::ostream& os) const noexcept {
 }
 
 bool Vendor::operator<(const Vendor& other) const {
-    return mac_prefix < other.mac_prefix;
+    return key() < other.key();
 }
 
 std::ostream& operator<<(std::ostream& os, const Vendor& v) {
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "VendorList.hpp"
+#include "exception.hpp"
+#include "utils.hpp"
+
+VendorList::VendorList(const VendorList& other) : rows{other.rows}, strings{other.strings} {
+    ids.reserve(strings.size());
+
+    for (size_t i = 0; i < strings.size(); i++) {
+        ids.emplace(strings[i], static_cast<uint32_t>(i));
+    }
+}
+
+VendorList& VendorList::operator=(const VendorList& other) {
+    if (this != &other) {
+        VendorList copy{other};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+std::string VendorList::date_of(const Row& r) const {
+    if (r.last_update == 0) {
+        return "";
+    }
+
+    if (r.last_update & RAW_DATE) {
+        return strings[r.last_update & ~RAW_DATE];
+    }
+
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%04u/%02u/%02u", r.last_update >> 9, (r.last_update >> 5) & 0xF, r.last_update & 0x1F);
+
+    return buf;
+}
+
+void VendorList::emplace_back(
+    const int64_t          mac_prefix,
+    const uint8_t          prefix_len,
+    const std::string_view vendor_name,
+    const bool             is_private,
+    const Registry         block_type,
+    const std::string_view last_update
+) {
+    rows.push_back(Row{
+        mac_prefix,
+        intern(vendor_name),
+        pack_date(last_update),
+        prefix_len,
+        is_private,
+        block_type,
+    });
+}
+
+void VendorList::emplace_back(const VendorList& other, const size_t i) {
+    const Row& r = other.rows[i];
+
+    uint32_t last_update = r.last_update;
+    if (last_update & RAW_DATE) {
+        last_update = intern(other.strings[last_update & ~RAW_DATE]) | RAW_DATE;
+    }
+
+    rows.push_back(Row{
+        r.mac_prefix,
+        intern(other.name_of(r)),
+        last_update,
+        r.prefix_len,
+        r.is_private,
+        r.block_type,
+    });
+}
+
+uint32_t VendorList::intern(const std::string_view str) {
+    if (const auto it = ids.find(str); it != ids.end()) {
+        return it->second;
+    }
+
+    if (strings.size() >= RAW_DATE) {
+        throw errors::Error{"string pool size limit exceeded"};
+    }
+
+    const auto id = static_cast<uint32_t>(strings.size());
+
+    ids.emplace(strings.emplace_back(str), id);
+
+    return id;
+}
+
+std::string_view VendorList::name_of(const Row& r) const noexcept {
+    return strings[r.name];
+}
+
+uint32_t VendorList::pack_date(const std::string_view date) {
+    if (date.empty()) {
+        return 0;
+    }
+
+    const auto digits = [&date](const size_t pos, const size_t len) -> int {
+        int value = 0;
+        for (size_t i = pos; i < pos + len; i++) {
+            if (date[i] < '0' || date[i] > '9') {
+                return -1;
+            }
+            value = value * 10 + (date[i] - '0');
+        }
+        return value;
+    };
+
+    if (date.size() == 10 && date[4] == '/' && date[7] == '/') {
+        const int year  = digits(0, 4);
+        const int month = digits(5, 2);
+        const int day   = digits(8, 2);
+
+        if (year >= 0 && month >= 1 && month <= 12 && day >= 1 && day <= 31) {
+            return static_cast<uint32_t>(year << 9 | month << 5 | day);
+        }
+    }
+
+    return intern(date) | RAW_DATE;
+}
+
+size_t VendorList::pool_size() const noexcept {
+    return strings.size();
+}
+
+void VendorList::push_back(const Vendor& v) {
+    emplace_back(v.mac_prefix, v.prefix_len, v.vendor_name, v.is_private, v.block_type, v.last_update);
+}
+
+void VendorList::reserve(const size_t n) {
+    rows.reserve(n);
+}
+
+const VendorList::Row& VendorList::row(const size_t i) const noexcept {
+    return rows[i];
+}
+
+size_t VendorList::size() const noexcept {
+    return rows.size();
+}
+
+void VendorList::sort() {
+    std::ranges::sort(rows, {}, &Row::key);
+}
+
+void VendorList::sort_unique() {
+    std::ranges::stable_sort(rows, {}, &Row::key);
+
+    const auto [first, last] = std::ranges::unique(rows, {}, &Row::key);
+    rows.erase(first, last);
+}
+
+VendorList::Iterator VendorList::begin() const noexcept {
+    return Iterator{this, 0};
+}
+
+VendorList::Iterator VendorList::end() const noexcept {
+    return Iterator{this, rows.size()};
+}
+
+Vendor VendorList::operator[](const size_t i) const {
+    const Row& r = rows[i];
+
+    return Vendor{
+        r.mac_prefix,
+        r.prefix_len,
+        std::string{name_of(r)},
+        r.is_private,
+        r.block_type,
+        date_of(r),
+    };
+}
+
+bool VendorList::operator==(const VendorList& other) const {
+    return std::ranges::equal(*this, other);
+}
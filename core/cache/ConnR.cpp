@@ -1,9 +1,53 @@
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "FuzzyIndex.hpp"
+#include "NameMatcher.hpp"
+#include "NameScanner.hpp"
 #include "cache/ConnR.hpp"
 #include "cache/Stmt.hpp"
 #include "cache/StmtPool.hpp"
 #include "exception.hpp"
 #include "utils.hpp"
 
+// Searches for the records with vendor names matching a LIKE pattern.
+// Narrows the candidates with the trigram index, then applies the pattern
+// to the candidates to keep its semantics.
+static constexpr const char* NAME_INDEX_STMT =
+    "SELECT * FROM vendor_rows WHERE name_id IN ("
+    "SELECT id FROM names "
+    "WHERE id IN (SELECT rowid FROM names_fts WHERE names_fts MATCH ?2) "
+    "AND name LIKE '%' || ?1 || '%' COLLATE NOCASE ESCAPE '\\')";
+
+// Loads the distinct vendor names of the names table into a NameScanner.
+// The ids of the names are stored in ids, by position.
+static NameScanner load_names(sqlite3* conn, std::vector<int64_t>& ids) {
+    Stmt scan{conn, "SELECT id, name FROM names"};
+
+    // Names stored back to back, with the end of each one
+    std::string         stored;
+    std::vector<size_t> ends;
+
+    while (scan.step() == SQLITE_ROW) {
+        ids.push_back(scan.get_col<int64_t>(0));
+        stored += scan.get_col<std::string_view>(1);
+        ends.push_back(stored.size());
+    }
+
+    std::vector<std::string_view> views;
+    views.reserve(ends.size());
+
+    for (size_t i = 0, begin = 0; i < ends.size(); begin = ends[i++]) {
+        views.emplace_back(stored.data() + begin, ends[i] - begin);
+    }
+
+    return NameScanner{views};
+}
+
 std::once_flag ConnR::db_checked{};
 
 ConnR::ConnR(const std::string& path, const bool override_once_flags)
@@ -46,35 +90,35 @@ int64_t ConnR::count_records() const {
     return stmt.get_col<int64_t>(0);
 }
 
-std::vector<Vendor> ConnR::export_records() const {
-    Stmt stmt{conn, "SELECT * FROM vendors"};
+VendorList ConnR::export_records() const {
+    Stmt stmt{conn, "SELECT * FROM vendor_rows"};
 
-    std::vector<Vendor> results;
+    VendorList results;
 
     while (stmt.step() == SQLITE_ROW) {
-        results.emplace_back(stmt.get_row());
+        stmt.get_row(results);
     }
 
     return results;
 }
 
-std::set<Vendor> ConnR::find_by_addr(std::span<const std::string> addresses) const {
+VendorList ConnR::find_by_addr(std::span<const std::string> addresses) const {
     if (addresses.empty()) {
         throw errors::Error{"no MAC address provided"};
     }
 
-    std::set<Vendor> results;
+    VendorList results;
 
     StmtPool pool;
 
     for (const auto& va : addresses) {
-        const std::string stripped_address = remove_addr_separators(va);
+        const MacAddr mac = parse_addr(va);
 
-        if (stripped_address.empty()) {
+        if (mac.len == 0) {
             throw errors::Error{"empty MAC address encountered"};
         }
 
-        const std::vector<int64_t> queries = construct_queries(stripped_address);
+        const Queries queries = construct_queries(mac);
 
         Stmt& stmt = pool.get(conn, queries.size());
 
@@ -83,43 +127,493 @@ std::set<Vendor> ConnR::find_by_addr(std::span<const std::string> addresses) con
         }
 
         while (stmt.step() == SQLITE_ROW) {
-            results.emplace(stmt.get_row());
+            stmt.get_row(results);
         }
 
         stmt.clear_bindings();
         stmt.reset();
     }
 
+    results.sort_unique();
+
     return results;
 }
 
-std::set<Vendor> ConnR::find_by_name(std::span<const std::string> names) const {
+VendorList ConnR::find_by_addr_batch(std::span<const std::string> addresses) const {
+    // Candidate prefixes are passed as a single JSON array
     constexpr const char* stmt_string =
-        "SELECT * FROM vendors "
-        "WHERE name LIKE '%' || ?1 || '%' COLLATE NOCASE ESCAPE '\\'";
+        "SELECT vendor_rows.* FROM json_each(?1) AS q "
+        "JOIN vendor_rows ON vendor_rows.prefix = q.value";
+
+    if (addresses.empty()) {
+        throw errors::Error{"no MAC address provided"};
+    }
+
+    std::vector<int64_t> queries;
+    queries.reserve(addresses.size() * 3);
+
+    for (const auto& va : addresses) {
+        const MacAddr mac = parse_addr(va);
 
+        if (mac.len == 0) {
+            throw errors::Error{"empty MAC address encountered"};
+        }
+
+        std::ranges::copy(construct_queries(mac), std::back_inserter(queries));
+    }
+
+    // Sorted keys let the join walk the prefix B-tree in order
+    std::ranges::sort(queries);
+    const auto [first, last] = std::ranges::unique(queries);
+    queries.erase(first, last);
+
+    std::string keys = "[";
+    for (const auto& q : queries) {
+        keys += std::to_string(q);
+        keys += ',';
+    }
+    keys.back() = ']';
+
+    Stmt stmt{conn, stmt_string};
+    stmt.bind(1, keys);
+
+    VendorList results;
+
+    int rc;
+    while ((rc = stmt.step()) == SQLITE_ROW) {
+        stmt.get_row(results);
+    }
+
+    if (rc != SQLITE_DONE) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::vector<std::optional<Vendor>> ConnR::find_best_by_addr(std::span<const std::string> addresses) const {
+    if (addresses.empty()) {
+        throw errors::Error{"no MAC address provided"};
+    }
+
+    // Greatest key not exceeding the most specific candidate
+    Stmt range{conn, "SELECT * FROM vendor_rows WHERE prefix <= ?1 ORDER BY prefix DESC LIMIT 1"};
+    Stmt point{conn, "SELECT * FROM vendor_rows WHERE prefix = ?1"};
+
+    std::vector<std::optional<Vendor>> results;
+    results.reserve(addresses.size());
+
+    for (const auto& va : addresses) {
+        const MacAddr mac = parse_addr(va);
+
+        if (mac.len == 0) {
+            throw errors::Error{"empty MAC address encountered"};
+        }
+
+        // Longer blocks of the same address have greater keys, so sorting
+        // in descending order puts the most specific candidate first.
+        Queries queries = construct_queries(mac);
+        queries.sort_descending();
+
+        std::optional<Vendor> best;
+
+        // Candidates below this key are left to point probes
+        int64_t limit = INT64_MIN;
+
+        range.bind(1, queries[0]);
+
+        if (range.step() == SQLITE_ROW) {
+            Vendor v = range.get_row();
+
+            if (std::ranges::find(queries, v.key()) != queries.end()) {
+                best = std::move(v);
+            } else {
+                // A sibling block lies between the address and its ancestors
+                limit = v.key();
+            }
+        }
+
+        range.clear_bindings();
+        range.reset();
+
+        for (auto q = queries.begin(); !best && q != queries.end(); q++) {
+            if (*q >= limit) {
+                continue;
+            }
+
+            point.bind(1, *q);
+
+            if (point.step() == SQLITE_ROW) {
+                best = point.get_row();
+            }
+
+            point.clear_bindings();
+            point.reset();
+        }
+
+        results.push_back(std::move(best));
+    }
+
+    return results;
+}
+
+VendorList ConnR::find_by_name(std::span<const std::string> names) const {
     if (names.empty()) {
         throw errors::Error{"no vendor names provided"};
     }
 
-    Stmt stmt{conn, stmt_string};
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    VendorList results;
+
+    // Terms scanned in memory: the ones without a run of 3 literal
+    // characters, or every term of a long list, for which a single
+    // pass over the distinct names replaces a lookup per term.
+    std::vector<std::string> unindexed;
+
+    {
+        Stmt index_stmt{conn, NAME_INDEX_STMT};
+
+        for (const auto& vn : names) {
+            const std::string query = names.size() < NameMatcher::MIN_TERMS ? trigram_query(vn) : std::string{};
+
+            if (query.empty()) {
+                unindexed.push_back(vn);
+                continue;
+            }
+
+            index_stmt.bind(1, vn);
+            index_stmt.bind(2, query);
+
+            while (index_stmt.step() == SQLITE_ROW) {
+                index_stmt.get_row(results);
+            }
+
+            index_stmt.clear_bindings();
+            index_stmt.reset();
+        }
+    }
+
+    if (!unindexed.empty()) {
+        std::vector<int64_t> ids;
+
+        // Ids of the matching names, as a JSON array
+        std::string matched = "[";
+
+        for (const auto i : load_names(conn, ids).find(unindexed)) {
+            matched += std::to_string(ids[i]);
+            matched += ',';
+        }
+
+        if (matched.size() > 1) {
+            matched.back() = ']';
+
+            Stmt stmt{conn, "SELECT * FROM vendor_rows WHERE name_id IN (SELECT value FROM json_each(?1))"};
+            stmt.bind(1, matched);
+
+            while (stmt.step() == SQLITE_ROW) {
+                stmt.get_row(results);
+            }
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::vector<VendorList> ConnR::find_by_name_grouped(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    std::vector<VendorList> groups(names.size());
+
+    // Terms scanned in memory, along with their positions in names
+    std::vector<std::string> unindexed;
+    std::vector<uint32_t>    unindexed_pos;
+
+    {
+        Stmt index_stmt{conn, NAME_INDEX_STMT};
+
+        for (size_t i = 0; i < names.size(); i++) {
+            const std::string query = names.size() < NameMatcher::MIN_TERMS ? trigram_query(names[i]) : std::string{};
+
+            if (query.empty()) {
+                unindexed.push_back(names[i]);
+                unindexed_pos.push_back(static_cast<uint32_t>(i));
+                continue;
+            }
+
+            index_stmt.bind(1, names[i]);
+            index_stmt.bind(2, query);
+
+            while (index_stmt.step() == SQLITE_ROW) {
+                index_stmt.get_row(groups[i]);
+            }
+
+            index_stmt.clear_bindings();
+            index_stmt.reset();
+        }
+    }
+
+    if (!unindexed.empty()) {
+        std::vector<int64_t> ids;
 
-    std::set<Vendor> results;
+        const auto found = load_names(conn, ids).find_each(unindexed);
+
+        // Positions in names of the terms matched by every name id
+        std::unordered_map<int64_t, std::vector<uint32_t>> terms_of;
+
+        for (size_t t = 0; t < found.size(); t++) {
+            for (const auto i : found[t]) {
+                terms_of[ids[i]].push_back(unindexed_pos[t]);
+            }
+        }
+
+        // Ids of the matching names, as a JSON array
+        std::string matched = "[";
+
+        for (const auto& [id, terms] : terms_of) {
+            matched += std::to_string(id);
+            matched += ',';
+        }
+
+        if (matched.size() > 1) {
+            matched.back() = ']';
+
+            Stmt stmt{conn, "SELECT * FROM vendor_rows WHERE name_id IN (SELECT value FROM json_each(?1))"};
+            stmt.bind(1, matched);
+
+            while (stmt.step() == SQLITE_ROW) {
+                for (const auto t : terms_of.at(stmt.get_col<int64_t>(5))) {
+                    stmt.get_row(groups[t]);
+                }
+            }
+        }
+    }
+
+    for (auto& g : groups) {
+        g.sort_unique();
+    }
+
+    return groups;
+}
+
+VendorList ConnR::find_exact(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
 
     for (const auto& vn : names) {
         if (vn.empty()) {
             throw errors::Error{"empty vendor name encountered"};
         }
+    }
+
+    Stmt stmt{conn, "SELECT * FROM vendor_rows WHERE name_id IN (SELECT id FROM names WHERE norm = ?1)"};
+
+    VendorList results;
+
+    for (const auto& vn : names) {
+        const std::string norm = normalize_name(vn);
+
+        // Names without letters or digits are normalized to NULL
+        if (norm.empty()) {
+            continue;
+        }
 
-        stmt.bind(1, vn);
+        stmt.bind(1, norm);
 
         while (stmt.step() == SQLITE_ROW) {
-            results.emplace(stmt.get_row());
+            stmt.get_row(results);
         }
 
         stmt.clear_bindings();
         stmt.reset();
     }
 
+    results.sort_unique();
+
     return results;
 }
+
+struct ConnR::FuzzyNames {
+    // PRAGMA data_version at the time of building.
+    int64_t data_version;
+
+    // Names stored back to back.
+    std::string strings;
+
+    // Ids of the names, parallel to the names of tables.
+    std::vector<int64_t> ids;
+
+    FuzzyIndex::Tables tables;
+    FuzzyIndex         index;
+
+    FuzzyNames(const int64_t data_version, std::string strings, std::vector<FuzzyIndex::Name> names, std::vector<int64_t> ids)
+        : data_version{data_version},
+          strings{std::move(strings)},
+          ids{std::move(ids)},
+          tables{FuzzyIndex::build(this->strings, std::move(names))},
+          index{this->strings, tables} {}
+};
+
+std::shared_ptr<const ConnR::FuzzyNames> ConnR::fuzzy_index() const {
+    // Changes whenever another connection commits to the database
+    Stmt version{conn, "PRAGMA data_version"};
+
+    if (const int rc = version.step(); rc != SQLITE_ROW) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+
+    const auto data_version = version.get_col<int64_t>(0);
+
+    const std::lock_guard lock{fuzzy_mutex};
+
+    if (fuzzy_names && fuzzy_names->data_version == data_version) {
+        return fuzzy_names;
+    }
+
+    std::string                   strings;
+    std::vector<FuzzyIndex::Name> entries;
+    std::vector<int64_t>          ids;
+
+    Stmt scan{conn, "SELECT id, name FROM names"};
+
+    while (scan.step() == SQLITE_ROW) {
+        const auto name = scan.get_col<std::string_view>(1);
+
+        entries.push_back({static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(name.size()), 0});
+        ids.push_back(scan.get_col<int64_t>(0));
+        strings += name;
+    }
+
+    fuzzy_names = std::make_shared<const FuzzyNames>(data_version, std::move(strings), std::move(entries), std::move(ids));
+
+    return fuzzy_names;
+}
+
+VendorList ConnR::find_fuzzy(std::span<const std::string> names, const size_t top) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    if (top == 0) {
+        throw errors::Error{"number of results must be positive"};
+    }
+
+    const auto fuzzy = fuzzy_index();
+
+    Stmt stmt{conn, "SELECT * FROM vendor_rows WHERE name_id = ?1 ORDER BY prefix"};
+
+    VendorList results;
+
+    // Keys of records already reported for a better match
+    std::unordered_set<int64_t> seen;
+
+    for (const auto& vn : names) {
+        for (const uint32_t n : fuzzy->index.find(vn, top)) {
+            stmt.bind(1, fuzzy->ids[n]);
+
+            while (stmt.step() == SQLITE_ROW) {
+                if (seen.insert(stmt.get_col<int64_t>(0)).second) {
+                    stmt.get_row(results);
+                }
+            }
+
+            stmt.clear_bindings();
+            stmt.reset();
+        }
+    }
+
+    return results;
+}
+
+VendorList ConnR::find_prefix(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    Stmt range_stmt{conn, "SELECT * FROM vendor_rows WHERE name_id IN (SELECT id FROM names WHERE norm >= ?1 AND norm < ?2)"};
+    Stmt tail_stmt{conn, "SELECT * FROM vendor_rows WHERE name_id IN (SELECT id FROM names WHERE norm >= ?1)"};
+
+    VendorList results;
+
+    for (const auto& vn : names) {
+        const std::string norm = normalize_name(vn);
+
+        if (norm.empty()) {
+            continue;
+        }
+
+        // The least string greater than every string starting with norm
+        std::string upper = norm;
+        while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xFF) {
+            upper.pop_back();
+        }
+
+        if (!upper.empty()) {
+            upper.back() = static_cast<char>(static_cast<unsigned char>(upper.back()) + 1);
+        }
+
+        // Without an upper bound, the range extends to the end of the index
+        Stmt& stmt = upper.empty() ? tail_stmt : range_stmt;
+
+        stmt.bind(1, norm);
+
+        if (!upper.empty()) {
+            stmt.bind(2, upper);
+        }
+
+        while (stmt.step() == SQLITE_ROW) {
+            stmt.get_row(results);
+        }
+
+        stmt.clear_bindings();
+        stmt.reset();
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::optional<std::string> ConnR::get_meta(const std::string& key) const {
+    Stmt stmt{conn, "SELECT value FROM meta WHERE key = ?1"};
+    stmt.bind(1, key);
+
+    const int rc = stmt.step();
+
+    if (rc == SQLITE_DONE) {
+        return std::nullopt;
+    } else if (rc != SQLITE_ROW) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+
+    return stmt.get_col<std::string>(0);
+}
@@ -1,8 +1,19 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
-
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Channel.hpp"
+#include "FinalAction.hpp"
 #include "Registry.hpp"
 #include "Vendor.hpp"
+#include "cache/ConnR.hpp"
 #include "cache/ConnRW.hpp"
 #include "cache/Stmt.hpp"
 #include "exception.hpp"
@@ -10,14 +21,212 @@
 
 std::once_flag ConnRW::db_prepared{};
 
+// Record inserted by customize_db, absent from the data source.
+static const Vendor CUSTOM_RECORD{0x024200, "Docker container interface (02:42)", true, Registry::Unknown, ""};
+
+// Number of batches parsed by parse_batches ahead of the writer.
+static constexpr size_t QUEUED_BATCHES = 8;
+
+// Parses CSV lines read from is into batches of Vendor structs and pushes
+// them to batches. Discards the first line. Returns early if batches
+// is closed by the consumer. Throws ParsingError if a malformed line
+// is encountered.
+static void parse_batches(std::istream& is, Channel<std::vector<Vendor>>& batches) {
+    // Lines parsed before the batch is handed over to the writer
+    constexpr size_t BATCH_SIZE = 512;
+
+    std::string line;
+
+    // Discard the header line
+    std::getline(is, line);
+
+    std::vector<Vendor> batch;
+    batch.reserve(BATCH_SIZE);
+
+    while (std::getline(is, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        batch.emplace_back(line);
+
+        if (batch.size() == BATCH_SIZE) {
+            if (!batches.push(std::move(batch))) {
+                return;
+            }
+            batch = {};
+            batch.reserve(BATCH_SIZE);
+        }
+    }
+
+    if (!batch.empty()) {
+        batches.push(std::move(batch));
+    }
+}
+
+// Returns a statement made of head, followed by width comma-separated
+// copies of row. Parameters ?1 to ?N of row are renumbered in every copy
+// to follow the ones of the previous copy.
+static std::string repeat_row(const std::string_view head, const std::string_view row, const int params, const size_t width) {
+    std::string stmt{head};
+
+    for (size_t i = 0; i < width; i++) {
+        stmt += i == 0 ? " " : ", ";
+
+        for (size_t pos = 0; pos < row.size(); pos++) {
+            stmt += row[pos];
+
+            if (row[pos] == '?') {
+                int n = 0;
+                for (; pos + 1 < row.size() && row[pos + 1] >= '0' && row[pos + 1] <= '9'; pos++) {
+                    n = n * 10 + (row[pos + 1] - '0');
+                }
+                stmt += std::to_string(static_cast<int>(i) * params + n);
+            }
+        }
+    }
+
+    return stmt;
+}
+
+// Executes a PRAGMA statement, discarding the value it may return.
+// Throws CacheError if a SQLite error is encountered.
+static void set_pragma(sqlite3* conn, const std::string& stmt_str) {
+    Stmt stmt{conn, stmt_str};
+
+    if (const int rc = stmt.step(); rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        throw errors::CacheError{stmt_str, __func__, rc};
+    }
+}
+
+// Returns the current value of pragma name, as text. Throws CacheError
+// if a SQLite error is encountered.
+static std::string get_pragma(sqlite3* conn, const std::string_view name) {
+    const std::string stmt_str = "PRAGMA " + std::string{name};
+
+    Stmt stmt{conn, stmt_str};
+
+    if (const int rc = stmt.step(); rc != SQLITE_ROW) {
+        throw errors::CacheError{stmt_str, __func__, rc};
+    }
+
+    return stmt.get_col<std::string>(0);
+}
+
+// Pragmas changed by begin_bulk_load, with their values in bulk-load mode.
+// The locking mode comes last, so that the exclusive lock is only released
+// once the others are restored.
+static constexpr std::array<std::pair<std::string_view, std::string_view>, 4> BULK_PRAGMAS{{
+    {"journal_mode", "MEMORY"},
+    {"synchronous", "OFF"},
+    {"cache_size", "-65536"},
+    {"locking_mode", "EXCLUSIVE"},
+}};
+
+// Parses the CSV lines contained in csv, past the header line, into blocks.
+// Blocks are parsed concurrently, by default one per hardware thread,
+// and stored in blocks. Returns the parsed records in ascending key order.
+// Throws ParsingError if a line is malformed.
+static std::vector<const VendorView*> parse_sorted(const std::string_view csv, size_t threads, std::vector<VendorBlock>& blocks) {
+    // Smallest block worth parsing on a separate thread
+    constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    // Discard the header line
+    const std::string_view lines = csv.substr(std::min(csv.find('\n'), csv.size() - 1) + 1);
+
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads = std::clamp(lines.size() / MIN_BLOCK_SIZE, size_t{1}, threads);
+
+    std::vector<std::future<VendorBlock>> parsed;
+
+    for (const auto block : split_lines(lines, threads)) {
+        parsed.push_back(std::async(std::launch::async, [block] { return VendorBlock{block}; }));
+    }
+
+    std::vector<const VendorView*> rows;
+
+    // Keeps the blocks in place, as rows point into them
+    blocks.reserve(parsed.size());
+
+    for (auto& p : parsed) {
+        // Rethrows the parsing error of the block, if any
+        const VendorBlock& block = blocks.emplace_back(p.get());
+
+        for (const auto& v : block.rows) {
+            rows.push_back(&v);
+        }
+    }
+
+    // Records of the IEEE registry are usually sorted already
+    const auto key = [](const VendorView* v) { return v->key(); };
+
+    if (!std::ranges::is_sorted(rows, {}, key)) {
+        std::ranges::stable_sort(rows, {}, key);
+    }
+
+    return rows;
+}
+
+ConnRW::RowWriter::RowWriter(ConnRW& conn, const size_t width)
+    : conn{conn},
+      name_stmt{conn.get(), INSERT_NAME_STMT},
+      stmt{conn.get(), INSERT_STMT},
+      width{width} {
+    rows.reserve(width);
+
+    if (width > 1) {
+        names_stmt.emplace(conn.get(), repeat_row("INSERT OR IGNORE INTO names (name, norm) VALUES", INSERT_NAME_ROW, 1, width));
+        rows_stmt.emplace(conn.get(), repeat_row("INSERT INTO vendors (prefix, name_id, private, block, updated, hash) VALUES", INSERT_ROW, 5, width));
+    }
+}
+
+void ConnRW::RowWriter::add(const VendorView& v) {
+    rows.push_back(v);
+
+    if (rows.size() == width) {
+        flush();
+    }
+}
+
+void ConnRW::RowWriter::flush() {
+    if (rows.size() < width || width == 1) {
+        for (const auto& v : rows) {
+            conn.insert_vendor(name_stmt, stmt, v);
+        }
+        rows.clear();
+        return;
+    }
+
+    // Names have to be present before the records refer to them. NULL
+    // names violate the NOT NULL constraint and are ignored.
+    for (size_t i = 0; i < width; i++) {
+        names_stmt->bind(static_cast<int>(i) + 1, rows[i].vendor_name);
+        rows_stmt->bind_row(static_cast<int>(i) * 5 + 1, rows[i]);
+    }
+
+    for (Stmt* s : {&*names_stmt, &*rows_stmt}) {
+        if (const int rc = s->step(); rc != SQLITE_DONE) {
+            throw errors::CacheError{"step", __func__, rc};
+        }
+        s->reset();
+    }
+
+    rows.clear();
+}
+
 ConnRW::ConnRW(const std::string& path, const bool override_once_flags)
     : Conn(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE),
       override_once_flags{override_once_flags},
-      transaction_open{false} {
+      transaction_open{false},
+      insert_width{1} {
     if (sqlite_open_rc != SQLITE_OK) {
         throw errors::CacheError{"open", __func__, sqlite_open_rc};
     }
 
+    register_functions();
+
     if (!override_once_flags) [[likely]] {
         std::call_once(db_prepared, [&] { prepare_db(); });
     } else [[unlikely]] {
@@ -39,8 +248,26 @@ void ConnRW::begin() {
     transaction_open = true;
 }
 
+void ConnRW::begin_bulk_load(const size_t width) {
+    assert(!transaction_open && "journal mode cannot be changed inside a transaction");
+
+    // Every record takes 5 parameters of the statement
+    const auto max_width = std::min(static_cast<size_t>(sqlite3_limit(conn, SQLITE_LIMIT_VARIABLE_NUMBER, -1) / 5), MAX_BULK_WIDTH);
+
+    for (size_t i = 0; i < BULK_PRAGMAS.size(); i++) {
+        const auto& [name, value] = BULK_PRAGMAS[i];
+
+        saved_pragmas[i] = get_pragma(conn, name);
+        set_pragma(conn, "PRAGMA " + std::string{name} + " = " + std::string{value});
+    }
+
+    insert_width = std::clamp(width, size_t{1}, max_width);
+}
+
 void ConnRW::clear_table() {
     exec("DELETE FROM vendors");
+    exec("DELETE FROM names");
+    exec("INSERT INTO names_fts(names_fts) VALUES('delete-all')");
 }
 
 void ConnRW::commit() {
@@ -48,29 +275,80 @@ void ConnRW::commit() {
     transaction_open = false;
 }
 
+void ConnRW::end_bulk_load() {
+    assert(!transaction_open && "journal mode cannot be changed inside a transaction");
+
+    for (size_t i = 0; i < BULK_PRAGMAS.size(); i++) {
+        set_pragma(conn, "PRAGMA " + std::string{BULK_PRAGMAS[i].first} + " = " + saved_pragmas[i]);
+    }
+
+    // The exclusive lock is released on the next access to the database
+    version();
+
+    insert_width = 1;
+}
+
 void ConnRW::create_table() {
+    exec(CREATE_NAMES_STMT);
+    exec(CREATE_NORM_INDEX_STMT);
     exec(CREATE_TABLE_STMT);
+    exec(CREATE_NAME_ID_INDEX_STMT);
+    exec(CREATE_VIEW_STMT);
+    exec(CREATE_INDEX_STMT);
+    exec(CREATE_META_STMT);
 }
 
 void ConnRW::customize_db(std::ostream& err) {
-    constexpr std::array<std::string_view, 2> mods{
-        "UPDATE vendors SET name = 'QEMU/KVM' WHERE prefix = 0x525400",
-        "UPDATE vendors SET name = name || ' (VirtualBox)' WHERE prefix = 0x080027",
+    // New vendor name of the record with cache key. If append is true,
+    // name is appended to the current one.
+    struct Mod {
+        int64_t          key;
+        std::string_view name;
+        bool             append;
     };
 
-    for (const auto& stmt : mods) {
-        exec(stmt);
+    constexpr std::array<Mod, 2> mods{{
+        {0x5254000000006, "QEMU/KVM", false},
+        {0x0800270000006, " (VirtualBox)", true},
+    }};
+
+    Stmt current{conn, "SELECT * FROM vendor_rows WHERE prefix = ?1"};
 
-        int changes = sqlite3_changes(conn);
+    for (const auto& m : mods) {
+        current.bind(1, m.key);
+
+        // Missing records are reported below
+        const std::optional<std::string> name = current.step() == SQLITE_ROW ? std::optional{current.get_col<std::string>(1)} : std::nullopt;
+
+        current.reset();
+
+        std::string new_name{m.name};
+
+        if (m.append && name) {
+            new_name = name->ends_with(m.name) ? *name : *name + new_name;
+        }
+
+        // Records modified by an earlier update are left intact
+        int changes = !name ? 0 : *name == new_name ? 1 : set_name(m.key, new_name);
         if (changes != 1) {
-            err << "[ " << __func__ << " ] " << stmt << ": unexpected number of changes (" << changes << ")\n";
+            const auto [prefix, len] = split_key(m.key);
+            err << "[ " << __func__ << " ] " << prefix_to_string(prefix, len) << ": unexpected number of changes (" << changes << ")\n";
         }
     }
 
+    current.bind(1, CUSTOM_RECORD.key());
+
+    // Inserted by an earlier update
+    if (current.step() == SQLITE_ROW && current.get_row() == CUSTOM_RECORD) {
+        return;
+    }
+    current.reset();
+
+    Stmt name_ins{conn, INSERT_NAME_STMT};
     Stmt ins{conn, INSERT_STMT};
 
     try {
-        ins.insert_row(Vendor{0x024200, "Docker container interface (02:42)", true, Registry::Unknown, ""});
+        insert_vendor(name_ins, ins, CUSTOM_RECORD);
     } catch (const errors::CacheError& e) {
         err << e << '\n';
         try {
@@ -84,7 +362,14 @@ void ConnRW::customize_db(std::ostream& err) {
 }
 
 void ConnRW::drop_table() {
+    exec("DROP VIEW IF EXISTS vendor_rows");
+    exec("DROP TABLE IF EXISTS names_fts");
     exec("DROP TABLE IF EXISTS vendors");
+    exec("DROP TABLE IF EXISTS names");
+    exec("DROP TABLE IF EXISTS meta");
+
+    // Name index of cache versions 8 and 9
+    exec("DROP TABLE IF EXISTS vendors_fts");
 }
 
 void ConnRW::exec(std::string_view stmt_str, const std::source_location loc) {
@@ -95,6 +380,30 @@ void ConnRW::exec(std::string_view stmt_str, const std::source_location loc) {
     }
 }
 
+void ConnRW::finish_insert(const bool update, std::ostream& err) {
+    if (update) {
+        customize_db(err);
+    }
+
+    exec(DELETE_UNUSED_NAMES_STMT);
+    exec(REBUILD_INDEX_STMT);
+
+    commit();
+}
+
+void ConnRW::insert_vendor(Stmt& name_stmt, Stmt& stmt, const VendorView& v) {
+    if (!v.vendor_name.empty()) {
+        name_stmt.bind(1, v.vendor_name);
+
+        if (const int rc = name_stmt.step(); rc != SQLITE_DONE) {
+            throw errors::CacheError{"step", __func__, rc};
+        }
+        name_stmt.reset();
+    }
+
+    stmt.insert_row(v);
+}
+
 void ConnRW::insert(std::istream& is, const bool update, std::ostream& err) {
     begin();
 
@@ -102,24 +411,194 @@ void ConnRW::insert(std::istream& is, const bool update, std::ostream& err) {
         clear_table();
     }
 
-    Stmt stmt{conn, INSERT_STMT};
+    RowWriter writer{*this, insert_width};
 
-    std::string line;
+    Channel<std::vector<Vendor>> batches{QUEUED_BATCHES};
+    std::exception_ptr           parse_error;
 
-    // Discard the header line
-    std::getline(is, line);
+    // Reading and parsing of is overlaps with the inserts below
+    std::thread parser{[&] {
+        try {
+            parse_batches(is, batches);
+        } catch (...) {
+            parse_error = std::current_exception();
+        }
+        batches.close();
+    }};
 
-    while (std::getline(is, line)) {
-        if (!line.empty()) {
-            stmt.insert_row(Vendor{line});
+    try {
+        while (const auto batch = batches.pop()) {
+            for (const auto& v : *batch) {
+                writer.add(v);
+            }
+            // Records of the batch are released with it
+            writer.flush();
         }
+    } catch (...) {
+        // Stops the parser
+        batches.close();
+        parser.join();
+        throw;
     }
 
+    parser.join();
+
+    if (parse_error) {
+        std::rethrow_exception(parse_error);
+    }
+
+    finish_insert(update, err);
+}
+
+void ConnRW::insert(const std::string_view csv, const bool update, std::ostream& err, size_t threads) {
+    std::vector<VendorBlock>             blocks;
+    const std::vector<const VendorView*> rows = parse_sorted(csv, threads, blocks);
+
+    begin();
+
     if (update) {
-        customize_db(err);
+        clear_table();
     }
 
-    commit();
+    RowWriter writer{*this, insert_width};
+
+    for (const VendorView* v : rows) {
+        writer.add(*v);
+    }
+    writer.flush();
+
+    finish_insert(update, err);
+}
+
+ConnRW::Changes ConnRW::merge(std::istream& is, std::ostream& err) {
+    begin();
+
+    try {
+        // Keys and hashes of the current records, in ascending key order
+        std::vector<std::pair<int64_t, int64_t>> current;
+
+        {
+            Stmt select{conn, "SELECT prefix, hash FROM vendors ORDER BY prefix"};
+
+            while (select.step() == SQLITE_ROW) {
+                current.emplace_back(select.get_col<int64_t>(0), select.get_col<int64_t>(1));
+            }
+        }
+
+        // Set for the current records found in the source
+        std::vector<bool> seen(current.size(), false);
+
+        exec(CREATE_INDEX_INSERT_TRIGGER);
+        exec(CREATE_INDEX_DELETE_TRIGGER);
+
+        Stmt      name_stmt{conn, INSERT_NAME_STMT};
+        Stmt      update_stmt{conn, UPDATE_STMT};
+        RowWriter writer{*this, insert_width};
+
+        Changes changes{};
+        size_t  received = 0;
+
+        Channel<std::vector<Vendor>> batches{QUEUED_BATCHES};
+        std::exception_ptr           parse_error;
+
+        // Reading and parsing of is overlaps with the writes below
+        std::thread parser{[&] {
+            try {
+                parse_batches(is, batches);
+            } catch (...) {
+                parse_error = std::current_exception();
+            }
+            batches.close();
+        }};
+
+        try {
+            while (const auto batch = batches.pop()) {
+                for (const auto& v : *batch) {
+                    received++;
+
+                    const auto   cur = std::ranges::lower_bound(current, v.key(), {}, &std::pair<int64_t, int64_t>::first);
+                    const size_t i   = static_cast<size_t>(cur - current.begin());
+
+                    // A repeated key is added again, to fail as it does in insert
+                    if (cur != current.end() && cur->first == v.key() && !seen[i]) {
+                        seen[i] = true;
+
+                        if (cur->second != VendorView{v}.hash()) {
+                            insert_vendor(name_stmt, update_stmt, v);
+                            changes.changed++;
+                        }
+                    } else {
+                        writer.add(v);
+                        changes.added++;
+                    }
+                }
+                // Records of the batch are released with it
+                writer.flush();
+            }
+        } catch (...) {
+            // Stops the parser
+            batches.close();
+            parser.join();
+            throw;
+        }
+
+        parser.join();
+
+        if (parse_error) {
+            std::rethrow_exception(parse_error);
+        }
+
+        // Every record of the cache would be removed
+        if (received == 0) {
+            throw errors::UpdateError{"update source contains no records"};
+        }
+
+        // Records absent from the source are removed, unless customize_db
+        // inserts them
+        std::vector<int64_t> removed;
+
+        for (size_t i = 0; i < current.size(); i++) {
+            if (!seen[i] && current[i].first != CUSTOM_RECORD.key()) {
+                removed.push_back(current[i].first);
+            }
+        }
+
+        if (static_cast<double>(removed.size()) > static_cast<double>(current.size()) * MAX_REMOVED_SHARE) {
+            throw errors::UpdateError{
+                "update source would remove " + std::to_string(removed.size()) + " of " + std::to_string(current.size()) + " records"
+            };
+        }
+
+        Stmt delete_stmt{conn, "DELETE FROM vendors WHERE prefix = ?1"};
+
+        for (const int64_t key : removed) {
+            delete_stmt.bind(1, key);
+
+            if (const int rc = delete_stmt.step(); rc != SQLITE_DONE) {
+                throw errors::CacheError{"step", __func__, rc};
+            }
+            delete_stmt.reset();
+        }
+
+        changes.removed = removed.size();
+
+        customize_db(err);
+
+        exec(DELETE_UNUSED_NAMES_STMT);
+
+        exec("DROP TRIGGER temp.names_fts_insert");
+        exec("DROP TRIGGER temp.names_fts_delete");
+
+        commit();
+
+        return changes;
+    } catch (...) {
+        // Reverts the records written so far, along with the triggers
+        if (transaction_open) {
+            rollback();
+        }
+        throw;
+    }
 }
 
 void ConnRW::prepare_db() {
@@ -138,6 +617,203 @@ void ConnRW::prepare_db() {
     }
 }
 
+size_t ConnRW::rebuild(const std::string& path, const std::function<void(ConnRW&)>& fill, const bool from_current) {
+    const std::string tmp_path = path + ".tmp";
+
+    std::error_code ec;
+
+    // Left by an interrupted update
+    std::filesystem::remove(tmp_path, ec);
+    std::filesystem::remove(tmp_path + "-journal", ec);
+
+    // The write lock of the old database is held across the swap. Taking it
+    // waits for writers of the old database to finish, and rolls back
+    // a journal left by one that crashed, so that no journal is applied
+    // to the new database.
+    sqlite3* old = nullptr;
+
+    const auto close_old = finally([&] { sqlite3_close(old); });
+
+    const auto lock_old = [&] {
+        if (!std::filesystem::exists(path, ec)) {
+            return;
+        }
+
+        if (const int rc = sqlite3_open_v2(path.c_str(), &old, SQLITE_OPEN_READWRITE, nullptr); rc != SQLITE_OK) {
+            throw errors::CacheError{"sqlite3_open_v2", __func__, rc};
+        }
+
+        sqlite3_busy_timeout(old, BUSY_TIMEOUT_MS);
+
+        if (const int rc = sqlite3_exec(old, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr); rc != SQLITE_OK) {
+            throw errors::CacheError{"cache '" + path + "' is locked", __func__, rc};
+        }
+    };
+
+    int64_t records = 0;
+
+    try {
+        // A copy of the current records is taken under the lock, so that
+        // no other writer changes them before the swap
+        if (from_current) {
+            lock_old();
+
+            const ConnR src{path, true};
+            Stmt        copy{src.get(), "VACUUM INTO ?1"};
+            copy.bind(1, tmp_path);
+
+            if (const int rc = copy.step(); rc != SQLITE_DONE) {
+                throw errors::CacheError{"step", __func__, rc};
+            }
+        }
+
+        {
+            // The new file is always prepared, regardless of db_prepared
+            ConnRW conn{tmp_path, true};
+
+            // The file is removed if the load fails
+            conn.begin_bulk_load();
+            fill(conn);
+
+            // customize_db inserts CUSTOM_RECORD into every cache, so only
+            // the other records show that the source held any
+            Stmt count{conn.conn, "SELECT count(*) FROM vendors WHERE prefix != ?1"};
+            count.bind(1, CUSTOM_RECORD.key());
+
+            if (const int rc = count.step(); rc != SQLITE_ROW) {
+                throw errors::CacheError{"step", __func__, rc};
+            }
+
+            if ((records = count.get_col<int64_t>(0)) == 0) {
+                throw errors::UpdateError{"update source contains no records"};
+            }
+
+            count.reset();
+            conn.end_bulk_load();
+        }
+
+        // Throws CacheError if the new cache is not ready for use
+        const ConnR check{tmp_path, true};
+    } catch (...) {
+        std::filesystem::remove(tmp_path, ec);
+        throw;
+    }
+
+    const auto remove_tmp = finally([&] { std::filesystem::remove(tmp_path, ec); });
+
+    if (!from_current) {
+        lock_old();
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (!ec) {
+        return static_cast<size_t>(records);
+    }
+
+    // The database cannot be renamed over while it is open on Windows,
+    // including by the lock above. The new cache is copied into it
+    // instead, with the locking of SQLite, so readers wait for the copy.
+    if (old == nullptr) {
+        throw errors::CacheError{"cache '" + path + "' could not be replaced"};
+    }
+
+    sqlite3_exec(old, "ROLLBACK", nullptr, nullptr, nullptr);
+
+    const ConnR src{tmp_path, true};
+
+    sqlite3_backup* backup = sqlite3_backup_init(old, "main", src.get(), "main");
+    if (backup == nullptr) {
+        throw errors::CacheError{"sqlite3_backup_init", __func__, sqlite3_errcode(old)};
+    }
+
+    sqlite3_backup_step(backup, -1);
+
+    if (const int rc = sqlite3_backup_finish(backup); rc != SQLITE_OK) {
+        throw errors::CacheError{"cache '" + path + "' could not be replaced", __func__, rc};
+    }
+
+    return static_cast<size_t>(records);
+}
+
+void ConnRW::register_functions() {
+    const auto normalize = [](sqlite3_context* ctx, int, sqlite3_value** argv) {
+        if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+            sqlite3_result_null(ctx);
+            return;
+        }
+
+        const auto* text = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+        const auto  len  = static_cast<size_t>(sqlite3_value_bytes(argv[0]));
+
+        if (!text) {
+            sqlite3_result_error_nomem(ctx);
+            return;
+        }
+
+        try {
+            const std::string norm = normalize_name({text, len});
+
+            if (norm.empty()) {
+                sqlite3_result_null(ctx);
+            } else {
+                sqlite3_result_text(ctx, norm.c_str(), static_cast<int>(norm.size()), SQLITE_TRANSIENT);
+            }
+        } catch (const std::bad_alloc&) {
+            sqlite3_result_error_nomem(ctx);
+        }
+    };
+
+    // NULL values are hashed as the fields that Stmt::bind_row binds
+    // as NULL
+    const auto row_hash = [](sqlite3_context* ctx, int, sqlite3_value** argv) {
+        const auto text = [](sqlite3_value* value) {
+            const auto* text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+            return text ? std::string_view{text, static_cast<size_t>(sqlite3_value_bytes(value))} : std::string_view{};
+        };
+
+        const Registry block = sqlite3_value_type(argv[2]) == SQLITE_NULL
+                                 ? Registry::Unknown
+                                 : static_cast<Registry>(sqlite3_value_int(argv[2]));
+
+        const VendorView v{0, 0, text(argv[0]), sqlite3_value_int(argv[1]) != 0, block, text(argv[3])};
+
+        sqlite3_result_int64(ctx, v.hash());
+    };
+
+    int rc = sqlite3_create_function_v2(
+        conn, "normalize_name", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, normalize, nullptr, nullptr, nullptr
+    );
+
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_create_function_v2(
+            conn, "row_hash", 4, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, row_hash, nullptr, nullptr, nullptr
+        );
+    }
+
+    if (rc != SQLITE_OK) {
+        throw errors::CacheError{"create_function", __func__, rc};
+    }
+}
+
+int ConnRW::set_name(const int64_t key, const std::string& name) {
+    Stmt name_stmt{conn, INSERT_NAME_STMT};
+    name_stmt.bind(1, name);
+
+    if (const int rc = name_stmt.step(); rc != SQLITE_DONE) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+
+    Stmt stmt{conn, "UPDATE vendors SET name_id = (SELECT id FROM names WHERE name = ?2) WHERE prefix = ?1"};
+    stmt.bind(1, key);
+    stmt.bind(2, name);
+
+    if (const int rc = stmt.step(); rc != SQLITE_DONE) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+
+    return sqlite3_changes(conn);
+}
+
 int ConnRW::rollback() noexcept {
     assert(transaction_open && "transaction has already been comitted");
 
@@ -148,6 +824,19 @@ int ConnRW::rollback() noexcept {
     return rc;
 }
 
+void ConnRW::set_meta(const std::string& key, const std::optional<std::string>& value) {
+    Stmt stmt{conn, value ? "INSERT OR REPLACE INTO meta (key, value) VALUES (?1, ?2)" : "DELETE FROM meta WHERE key = ?1"};
+
+    stmt.bind(1, key);
+    if (value) {
+        stmt.bind(2, *value);
+    }
+
+    if (const int rc = stmt.step(); rc != SQLITE_DONE) {
+        throw errors::CacheError{"step", __func__, rc};
+    }
+}
+
 void ConnRW::set_version(const int version) {
     exec("PRAGMA user_version = " + std::to_string(version));
 }
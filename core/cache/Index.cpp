@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#include "cache/Index.hpp"
+#include "exception.hpp"
+#include "utils.hpp"
+
+Index::Index(const ConnR& conn, size_t threads) : records{conn.export_records()}, names{names_of(records), threads} {
+    // <key, row id> pairs for each bucket, sorted by key
+    std::array<std::vector<std::pair<int64_t, uint32_t>>, MAC_NIBBLES + 1> sorted;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const int64_t key = records.row(i).key();
+        sorted[bucket_of(key)].emplace_back(key, static_cast<uint32_t>(i));
+    }
+
+    for (size_t b = 0; b < buckets.size(); b++) {
+        auto& src = sorted[b];
+        auto& dst = buckets[b];
+
+        std::ranges::sort(src);
+
+        dst.keys.resize(src.size() + 1);
+        dst.rows.resize(src.size() + 1);
+
+        // In-order traversal of the implicit tree assigns sorted keys
+        // to their Eytzinger positions.
+        size_t next = 0;
+
+        const auto fill = [&](const auto& self, const size_t k) -> void {
+            if (k > src.size()) {
+                return;
+            }
+            self(self, 2 * k);
+            dst.keys[k] = src[next].first;
+            dst.rows[k] = src[next].second;
+            next++;
+            self(self, 2 * k + 1);
+        };
+
+        fill(fill, 1);
+    }
+}
+
+size_t Index::bucket_of(const int64_t key) noexcept {
+    return split_key(key).second;
+}
+
+const uint32_t* Index::Bucket::find(const int64_t key) const noexcept {
+    const size_t n = keys.size() - 1;
+
+    size_t k = 1;
+    while (k <= n) {
+        k = 2 * k + static_cast<size_t>(keys[k] < key);
+    }
+
+    // Strip the trailing right turns to recover the lower bound position
+    k >>= std::countr_one(k) + 1;
+
+    if (k == 0 || keys[k] != key) {
+        return nullptr;
+    }
+    return &rows[k];
+}
+
+VendorList Index::find_by_addr(std::span<const std::string> addresses) const {
+    if (addresses.empty()) {
+        throw errors::Error{"no MAC address provided"};
+    }
+
+    VendorList results;
+
+    for (const auto& va : addresses) {
+        const MacAddr mac = parse_addr(va);
+
+        if (mac.len == 0) {
+            throw errors::Error{"empty MAC address encountered"};
+        }
+
+        for (const auto& q : construct_queries(mac)) {
+            if (const uint32_t* row = buckets[bucket_of(q)].find(q); row) {
+                results.emplace_back(records, *row);
+            }
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+VendorList Index::find_by_name(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    VendorList results;
+
+    for (const auto row : this->names.find(names)) {
+        results.emplace_back(records, row);
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::vector<std::string_view> Index::names_of(const VendorList& records) {
+    std::vector<std::string_view> names;
+    names.reserve(records.size());
+
+    for (size_t i = 0; i < records.size(); i++) {
+        names.push_back(records.name_of(records.row(i)));
+    }
+
+    return names;
+}
+
+size_t Index::size() const noexcept {
+    return records.size();
+}
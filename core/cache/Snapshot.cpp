@@ -0,0 +1,798 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "NameMatcher.hpp"
+#include "cache/Conn.hpp"
+#include "cache/Snapshot.hpp"
+#include "exception.hpp"
+#include "utils.hpp"
+
+// Flushes the file or directory at path to the disk. Returns false on
+// failure. Directories cannot be flushed on Windows, where renames
+// are journaled by the file system.
+static bool sync_path(const std::string& path, const bool directory) {
+#if defined(_WIN32)
+    if (directory) {
+        return true;
+    }
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    const bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+#else
+    const int fd = open(path.c_str(), (directory ? O_RDONLY | O_DIRECTORY : O_WRONLY) | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    const bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+Snapshot::Snapshot(const std::string& path, const std::string& db_path) : data{nullptr}, size{0} {
+#if defined(_WIN32)
+    mapping = nullptr;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw errors::CacheError{"snapshot '" + path + "' could not be opened"};
+    }
+
+    LARGE_INTEGER fsize;
+    if (!GetFileSizeEx(file, &fsize) || fsize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        throw errors::CacheError{"snapshot '" + path + "' is truncated"};
+    }
+    size = static_cast<size_t>(fsize.QuadPart);
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (!mapping) {
+        throw errors::CacheError{"snapshot '" + path + "' could not be mapped"};
+    }
+
+    if (!(data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)))) {
+        CloseHandle(mapping);
+        throw errors::CacheError{"snapshot '" + path + "' could not be mapped"};
+    }
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw errors::CacheError{"snapshot '" + path + "' could not be opened"};
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        close(fd);
+        throw errors::CacheError{"snapshot '" + path + "' is truncated"};
+    }
+    size = static_cast<size_t>(st.st_size);
+
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        throw errors::CacheError{"snapshot '" + path + "' could not be mapped"};
+    }
+    data = static_cast<const std::byte*>(addr);
+#endif
+
+    // Unmaps the file if validation fails, since the destructor
+    // will not run for a partially constructed object.
+    const auto fail = [&](const std::string& msg) {
+#if defined(_WIN32)
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+#else
+        munmap(const_cast<std::byte*>(data), size);
+#endif
+        throw errors::CacheError{"snapshot '" + path + "' " + msg};
+    };
+
+    Header hdr;
+    std::memcpy(&hdr, data, sizeof(Header));
+
+    if (std::memcmp(hdr.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        fail("is not a snapshot file");
+    }
+
+    if (hdr.format_version != FORMAT_VERSION || hdr.cache_version != Conn::EXPECTED_CACHE_VERSION) {
+        fail("version mismatch");
+    }
+
+    if (DbStamp{hdr.db_size, hdr.db_mtime, hdr.db_changes} != stamp_db(db_path)) {
+        fail("is outdated");
+    }
+
+    if (hdr.count == 0) {
+        fail("contains no records");
+    }
+
+    constexpr size_t OUI_INDEX_SIZE = OUI_WORDS * (sizeof(uint64_t) + sizeof(uint32_t));
+
+    const size_t payload = size - sizeof(Header);
+
+    if (hdr.count > payload / (sizeof(int64_t) + sizeof(Record)) || hdr.oui_count > hdr.count || hdr.refined_count > hdr.count) {
+        fail("is corrupted");
+    }
+
+    if (hdr.name_count > hdr.count || hdr.named_count > hdr.count || hdr.norm_count > hdr.name_count || hdr.gram_count > payload / sizeof(uint32_t) || hdr.posting_count > payload / sizeof(uint32_t)) {
+        fail("is corrupted");
+    }
+
+    const size_t fixed = hdr.count * (sizeof(int64_t) + sizeof(Record)) + OUI_INDEX_SIZE
+                       + (hdr.oui_count + hdr.refined_count) * sizeof(uint32_t)
+                       + hdr.name_count * sizeof(FuzzyIndex::Name)
+                       + (hdr.name_count + 1 + hdr.named_count + 2 * hdr.gram_count + 1 + hdr.posting_count) * sizeof(uint32_t)
+                       + hdr.norm_count * sizeof(NormName);
+
+    if (fixed > payload || hdr.strings_size != payload - fixed) {
+        fail("is corrupted");
+    }
+
+    const std::byte* keys_begin      = data + sizeof(Header);
+    const std::byte* records_begin   = keys_begin + hdr.count * sizeof(int64_t);
+    const std::byte* oui_bits_begin  = records_begin + hdr.count * sizeof(Record);
+    const std::byte* oui_ranks_begin = oui_bits_begin + OUI_WORDS * sizeof(uint64_t);
+    const std::byte* oui_rows_begin  = oui_ranks_begin + OUI_WORDS * sizeof(uint32_t);
+    const std::byte* refined_begin   = oui_rows_begin + hdr.oui_count * sizeof(uint32_t);
+    const std::byte* names_begin     = refined_begin + hdr.refined_count * sizeof(uint32_t);
+    const std::byte* ranges_begin    = names_begin + hdr.name_count * sizeof(FuzzyIndex::Name);
+    const std::byte* name_rows_begin = ranges_begin + (hdr.name_count + 1) * sizeof(uint32_t);
+    const std::byte* gram_keys_begin = name_rows_begin + hdr.named_count * sizeof(uint32_t);
+    const std::byte* gram_offs_begin = gram_keys_begin + hdr.gram_count * sizeof(uint32_t);
+    const std::byte* postings_begin  = gram_offs_begin + (hdr.gram_count + 1) * sizeof(uint32_t);
+    const std::byte* norms_begin     = postings_begin + hdr.posting_count * sizeof(uint32_t);
+    const std::byte* strings_begin   = norms_begin + hdr.norm_count * sizeof(NormName);
+
+    keys      = {reinterpret_cast<const int64_t*>(keys_begin), hdr.count};
+    records   = {reinterpret_cast<const Record*>(records_begin), hdr.count};
+    oui_bits  = {reinterpret_cast<const uint64_t*>(oui_bits_begin), OUI_WORDS};
+    oui_ranks = {reinterpret_cast<const uint32_t*>(oui_ranks_begin), OUI_WORDS};
+    oui_rows  = {reinterpret_cast<const uint32_t*>(oui_rows_begin), hdr.oui_count};
+    refined   = {reinterpret_cast<const uint32_t*>(refined_begin), hdr.refined_count};
+    strings   = {reinterpret_cast<const char*>(strings_begin), hdr.strings_size};
+
+    fuzzy_names   = {reinterpret_cast<const FuzzyIndex::Name*>(names_begin), hdr.name_count};
+    name_ranges   = {reinterpret_cast<const uint32_t*>(ranges_begin), hdr.name_count + 1};
+    name_rows     = {reinterpret_cast<const uint32_t*>(name_rows_begin), hdr.named_count};
+    gram_keys     = {reinterpret_cast<const uint32_t*>(gram_keys_begin), hdr.gram_count};
+    gram_offs     = {reinterpret_cast<const uint32_t*>(gram_offs_begin), hdr.gram_count + 1};
+    gram_postings = {reinterpret_cast<const uint32_t*>(postings_begin), hdr.posting_count};
+    norm_names    = {reinterpret_cast<const NormName*>(norms_begin), hdr.norm_count};
+
+    // The last rank must account for every MA-L sized record
+    if (oui_ranks.back() + static_cast<uint64_t>(std::popcount(oui_bits.back())) != hdr.oui_count) {
+        fail("is corrupted");
+    }
+}
+
+Snapshot::~Snapshot() {
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+#else
+    munmap(const_cast<std::byte*>(data), size);
+#endif
+}
+
+VendorList Snapshot::export_records() const {
+    VendorList results;
+    results.reserve(keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        get_row(i, results);
+    }
+
+    return results;
+}
+
+VendorList Snapshot::find_by_addr(std::span<const std::string> addresses) const {
+    if (addresses.empty()) {
+        throw errors::Error{"no MAC address provided"};
+    }
+
+    VendorList results;
+
+    for (const auto& va : addresses) {
+        const MacAddr mac = parse_addr(va);
+
+        if (mac.len == 0) {
+            throw errors::Error{"empty MAC address encountered"};
+        }
+
+        for (const auto& q : construct_queries(mac)) {
+            if (const auto i = find_key(q)) {
+                get_row(*i, results);
+            }
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::vector<std::optional<Vendor>> Snapshot::find_best_by_addr(std::span<const std::string> addresses) const {
+    if (addresses.empty()) {
+        throw errors::Error{"no MAC address provided"};
+    }
+
+    std::vector<std::optional<Vendor>> results;
+    results.reserve(addresses.size());
+
+    for (const auto& va : addresses) {
+        const MacAddr mac = parse_addr(va);
+
+        if (mac.len == 0) {
+            throw errors::Error{"empty MAC address encountered"};
+        }
+
+        Queries queries = construct_queries(mac);
+        queries.sort_descending();
+
+        std::optional<Vendor> best;
+
+        // Blocks longer than MA-L exist only within refined OUIs, so
+        // most addresses are resolved by the bitmap alone.
+        const bool is_refined = std::ranges::binary_search(refined, static_cast<uint32_t>(mac.value >> 24));
+
+        for (auto q = queries.begin(); !best && q != queries.end(); q++) {
+            if (!is_refined && split_key(*q).second > 6) {
+                continue;
+            }
+
+            if (const auto i = find_key(*q)) {
+                best = get_row(*i);
+            }
+        }
+
+        results.push_back(std::move(best));
+    }
+
+    return results;
+}
+
+VendorList Snapshot::find_by_name(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    const NameMatcher matcher{names};
+
+    VendorList results;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        // Empty names are stored as NULL in the database and never
+        // match a LIKE pattern.
+        const std::string_view name = get_string(records[i].name_off, records[i].name_len);
+
+        if (!name.empty() && matcher.matches(name)) {
+            get_row(i, results);
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::vector<VendorList> Snapshot::find_by_name_grouped(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    const NameMatcher matcher{names};
+
+    std::vector<VendorList> groups(names.size());
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const std::string_view name = get_string(records[i].name_off, records[i].name_len);
+
+        if (name.empty()) {
+            continue;
+        }
+
+        for (const uint32_t t : matcher.match(name)) {
+            get_row(i, groups[t]);
+        }
+    }
+
+    for (auto& g : groups) {
+        g.sort_unique();
+    }
+
+    return groups;
+}
+
+VendorList Snapshot::find_exact(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    const auto norm_of = [this](const NormName& n) { return get_string(n.off, n.len); };
+
+    VendorList results;
+
+    for (const auto& vn : names) {
+        const std::string norm = normalize_name(vn);
+
+        if (norm.empty()) {
+            continue;
+        }
+
+        for (const NormName& n : std::ranges::equal_range(norm_names, std::string_view{norm}, {}, norm_of)) {
+            for (const uint32_t i : rows_of(n.name)) {
+                get_row(i, results);
+            }
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+VendorList Snapshot::find_fuzzy(std::span<const std::string> names, const size_t top) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    if (top == 0) {
+        throw errors::Error{"number of results must be positive"};
+    }
+
+    const FuzzyIndex index{strings, fuzzy_names, gram_keys, gram_offs, gram_postings};
+
+    VendorList results;
+
+    // Records already reported for a better match
+    std::vector<bool> seen(records.size());
+
+    for (const auto& vn : names) {
+        for (const uint32_t n : index.find(vn, top)) {
+            for (const uint32_t i : rows_of(n)) {
+                if (!seen[i]) {
+                    seen[i] = true;
+                    get_row(i, results);
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+VendorList Snapshot::find_prefix(std::span<const std::string> names) const {
+    if (names.empty()) {
+        throw errors::Error{"no vendor names provided"};
+    }
+
+    for (const auto& vn : names) {
+        if (vn.empty()) {
+            throw errors::Error{"empty vendor name encountered"};
+        }
+    }
+
+    const auto norm_of = [this](const NormName& n) { return get_string(n.off, n.len); };
+
+    VendorList results;
+
+    for (const auto& vn : names) {
+        const std::string norm = normalize_name(vn);
+
+        if (norm.empty()) {
+            continue;
+        }
+
+        auto it = std::ranges::lower_bound(norm_names, std::string_view{norm}, {}, norm_of);
+
+        for (; it != norm_names.end() && norm_of(*it).starts_with(norm); it++) {
+            for (const uint32_t i : rows_of(it->name)) {
+                get_row(i, results);
+            }
+        }
+    }
+
+    results.sort_unique();
+
+    return results;
+}
+
+std::optional<size_t> Snapshot::find_key(const int64_t key) const {
+    const auto [prefix, len] = split_key(key);
+
+    if (len == 6) {
+        const auto     oui  = static_cast<size_t>(prefix);
+        const uint64_t word = oui_bits[oui / 64];
+        const uint64_t bit  = uint64_t{1} << (oui % 64);
+
+        if (!(word & bit)) {
+            return std::nullopt;
+        }
+
+        const size_t rank = oui_ranks[oui / 64] + static_cast<size_t>(std::popcount(word & (bit - 1)));
+
+        if (rank >= oui_rows.size() || oui_rows[rank] >= keys.size()) {
+            throw errors::CacheError{"snapshot is corrupted"};
+        }
+
+        return oui_rows[rank];
+    }
+
+    if (len > 6 && !std::ranges::binary_search(refined, static_cast<uint32_t>(prefix >> (4 * (len - 6))))) {
+        return std::nullopt;
+    }
+
+    if (const auto it = std::ranges::lower_bound(keys, key); it != keys.end() && *it == key) {
+        return static_cast<size_t>(it - keys.begin());
+    }
+
+    return std::nullopt;
+}
+
+Vendor Snapshot::get_row(const size_t i) const {
+    const Record& r = records[i];
+
+    Registry block_type = Registry::Unknown;
+    if (r.block_type <= static_cast<uint8_t>(Registry::MA_S)) {
+        block_type = static_cast<Registry>(r.block_type);
+    }
+
+    const auto [prefix, len] = split_key(keys[i]);
+
+    return Vendor{
+        prefix,
+        static_cast<uint8_t>(len),
+        std::string{get_string(r.name_off, r.name_len)},
+        r.is_private == 1,
+        block_type,
+        std::string{get_string(r.updated_off, r.updated_len)},
+    };
+}
+
+void Snapshot::get_row(const size_t i, VendorList& list) const {
+    const Record& r = records[i];
+
+    const auto [prefix, len] = split_key(keys[i]);
+
+    Registry block_type = Registry::Unknown;
+    if (r.block_type <= static_cast<uint8_t>(Registry::MA_S)) {
+        block_type = static_cast<Registry>(r.block_type);
+    }
+
+    list.emplace_back(
+        prefix,
+        static_cast<uint8_t>(len),
+        get_string(r.name_off, r.name_len),
+        r.is_private == 1,
+        block_type,
+        get_string(r.updated_off, r.updated_len)
+    );
+}
+
+std::string_view Snapshot::get_string(const uint32_t off, const uint32_t len) const {
+    if (off > strings.size() || len > strings.size() - off) {
+        throw errors::CacheError{"snapshot is corrupted"};
+    }
+    return strings.substr(off, len);
+}
+
+std::string Snapshot::path_for(const std::string& db_path) {
+    return std::filesystem::path{db_path}.replace_extension(".snap").string();
+}
+
+Snapshot::DbStamp Snapshot::stamp_db(const std::string& db_path) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+
+    const auto db_size = fs::file_size(db_path, ec);
+    if (ec) {
+        throw errors::CacheError{"database '" + db_path + "' could not be accessed"};
+    }
+
+    const auto db_mtime = fs::last_write_time(db_path, ec);
+    if (ec) {
+        throw errors::CacheError{"database '" + db_path + "' could not be accessed"};
+    }
+
+    // The counter is stored big-endian at offset 24 of the database header.
+    // A database without pages has no header and the counter is 0.
+    std::ifstream file{db_path, std::ios::binary};
+    if (!file) {
+        throw errors::CacheError{"database '" + db_path + "' could not be accessed"};
+    }
+
+    unsigned char header[28] = {};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (file.bad()) {
+        throw errors::CacheError{"database '" + db_path + "' could not be accessed"};
+    }
+
+    const uint32_t changes = uint32_t{header[24]} << 24 | uint32_t{header[25]} << 16 | uint32_t{header[26]} << 8 | uint32_t{header[27]};
+
+    return {static_cast<int64_t>(db_size), static_cast<int64_t>(db_mtime.time_since_epoch().count()), changes};
+}
+
+std::span<const uint32_t> Snapshot::rows_of(const uint32_t name) const {
+    if (static_cast<size_t>(name) + 1 >= name_ranges.size()) {
+        throw errors::CacheError{"snapshot is corrupted"};
+    }
+
+    const uint32_t first = name_ranges[name];
+    const uint32_t last  = name_ranges[name + 1];
+
+    if (first > last || last > name_rows.size()) {
+        throw errors::CacheError{"snapshot is corrupted"};
+    }
+
+    const std::span<const uint32_t> rows = name_rows.subspan(first, last - first);
+
+    for (const uint32_t i : rows) {
+        if (i >= records.size()) {
+            throw errors::CacheError{"snapshot is corrupted"};
+        }
+    }
+
+    return rows;
+}
+
+void Snapshot::write(const std::string& path, const std::string& db_path, VendorList records) {
+    records.sort();
+
+    std::vector<int64_t> keys;
+    std::vector<Record>  recs;
+    std::string          strings;
+
+    keys.reserve(records.size());
+    recs.reserve(records.size());
+
+    std::vector<uint64_t> oui_bits(OUI_WORDS);
+    std::vector<uint32_t> oui_ranks(OUI_WORDS);
+    std::vector<uint32_t> oui_rows;
+    std::vector<uint32_t> refined;
+
+    // Offsets of strings already present in the blob, by string pool id
+    // and by packed date
+    std::unordered_map<uint32_t, uint32_t> name_offs;
+    std::unordered_map<uint32_t, uint32_t> date_offs;
+
+    // Distinct non-empty names, their positions by string pool id
+    // and the position of the name of every record
+    std::vector<FuzzyIndex::Name>          fuzzy_names;
+    std::unordered_map<uint32_t, uint32_t> name_ids;
+    std::vector<uint32_t>                  record_names;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const VendorList::Row& v = records.row(i);
+
+        const std::string_view name = records.name_of(v);
+        const std::string      date = records.date_of(v);
+
+        if (strings.size() + name.size() + date.size() > UINT32_MAX || date.size() > UINT8_MAX) {
+            throw errors::CacheError{"snapshot size limit exceeded"};
+        }
+
+        Record r{};
+
+        const auto [name_it, new_name] = name_offs.try_emplace(v.name, static_cast<uint32_t>(strings.size()));
+        if (new_name) {
+            strings += name;
+        }
+        r.name_off = name_it->second;
+        r.name_len = static_cast<uint32_t>(name.size());
+
+        if (!name.empty()) {
+            const auto [id_it, new_id] = name_ids.try_emplace(v.name, static_cast<uint32_t>(fuzzy_names.size()));
+            if (new_id) {
+                fuzzy_names.push_back({r.name_off, r.name_len, 0});
+            }
+            record_names.push_back(id_it->second);
+        } else {
+            record_names.push_back(UINT32_MAX);
+        }
+
+        const auto [date_it, new_date] = date_offs.try_emplace(v.last_update, static_cast<uint32_t>(strings.size()));
+        if (new_date) {
+            strings += date;
+        }
+        r.updated_off = date_it->second;
+        r.updated_len = static_cast<uint8_t>(date.size());
+
+        r.is_private = v.is_private ? 1 : 0;
+        r.block_type = static_cast<uint8_t>(v.block_type);
+
+        // Records are sorted by key, so OUIs are visited in ascending order
+        if (v.prefix_len == 6) {
+            const auto     oui = static_cast<size_t>(v.mac_prefix);
+            const uint64_t bit = uint64_t{1} << (oui % 64);
+
+            if (!(oui_bits[oui / 64] & bit)) {
+                oui_bits[oui / 64] |= bit;
+                oui_rows.push_back(static_cast<uint32_t>(keys.size()));
+            }
+        } else if (v.prefix_len > 6) {
+            const auto oui = static_cast<uint32_t>(v.mac_prefix >> (4 * (v.prefix_len - 6)));
+
+            if (refined.empty() || refined.back() != oui) {
+                refined.push_back(oui);
+            }
+        }
+
+        keys.push_back(v.key());
+        recs.push_back(r);
+    }
+
+    for (size_t w = 1; w < OUI_WORDS; w++) {
+        oui_ranks[w] = oui_ranks[w - 1] + static_cast<uint32_t>(std::popcount(oui_bits[w - 1]));
+    }
+
+    // Groups records by name, keeping them in key order within each group
+    std::vector<uint32_t> name_ranges(fuzzy_names.size() + 1);
+
+    for (const uint32_t n : record_names) {
+        if (n != UINT32_MAX) {
+            name_ranges[n + 1]++;
+        }
+    }
+
+    for (size_t n = 1; n < name_ranges.size(); n++) {
+        name_ranges[n] += name_ranges[n - 1];
+    }
+
+    std::vector<uint32_t> name_rows(name_ranges.back());
+    std::vector<uint32_t> next_row(name_ranges.begin(), name_ranges.end() - 1);
+
+    for (size_t i = 0; i < record_names.size(); i++) {
+        if (record_names[i] != UINT32_MAX) {
+            name_rows[next_row[record_names[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Normalized forms of the names, sorted. Names normalized to the same
+    // string share its copy in the blob.
+    std::vector<NormName>                     norm_names;
+    std::unordered_map<std::string, uint32_t> norm_offs;
+
+    for (size_t n = 0; n < fuzzy_names.size(); n++) {
+        const std::string norm = normalize_name(std::string_view{strings}.substr(fuzzy_names[n].off, fuzzy_names[n].len));
+
+        if (norm.empty()) {
+            continue;
+        }
+
+        if (strings.size() + norm.size() > UINT32_MAX) {
+            throw errors::CacheError{"snapshot size limit exceeded"};
+        }
+
+        const auto [norm_it, new_norm] = norm_offs.try_emplace(norm, static_cast<uint32_t>(strings.size()));
+        if (new_norm) {
+            strings += norm;
+        }
+
+        norm_names.push_back({norm_it->second, static_cast<uint32_t>(norm.size()), static_cast<uint32_t>(n)});
+    }
+
+    std::ranges::sort(norm_names, [&strings](const NormName& a, const NormName& b) {
+        const std::string_view blob{strings};
+        return std::pair{blob.substr(a.off, a.len), a.name} < std::pair{blob.substr(b.off, b.len), b.name};
+    });
+
+    const FuzzyIndex::Tables grams = FuzzyIndex::build(strings, std::move(fuzzy_names));
+
+    Header hdr{};
+    std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.format_version = FORMAT_VERSION;
+    hdr.cache_version  = Conn::EXPECTED_CACHE_VERSION;
+    hdr.count          = keys.size();
+    hdr.oui_count      = oui_rows.size();
+    hdr.refined_count  = refined.size();
+    hdr.name_count     = grams.names.size();
+    hdr.named_count    = name_rows.size();
+    hdr.gram_count     = grams.keys.size();
+    hdr.posting_count  = grams.postings.size();
+    hdr.norm_count     = norm_names.size();
+    hdr.strings_size   = strings.size();
+
+    const DbStamp stamp = stamp_db(db_path);
+    hdr.db_size         = stamp.size;
+    hdr.db_mtime        = stamp.mtime;
+    hdr.db_changes      = stamp.changes;
+    hdr.padding         = 0;
+
+    const std::string tmp_path = path + ".tmp";
+
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+
+        file.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        file.write(reinterpret_cast<const char*>(keys.data()), static_cast<std::streamsize>(keys.size() * sizeof(int64_t)));
+        file.write(reinterpret_cast<const char*>(recs.data()), static_cast<std::streamsize>(recs.size() * sizeof(Record)));
+        file.write(reinterpret_cast<const char*>(oui_bits.data()), static_cast<std::streamsize>(oui_bits.size() * sizeof(uint64_t)));
+        file.write(reinterpret_cast<const char*>(oui_ranks.data()), static_cast<std::streamsize>(oui_ranks.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(oui_rows.data()), static_cast<std::streamsize>(oui_rows.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(refined.data()), static_cast<std::streamsize>(refined.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(grams.names.data()), static_cast<std::streamsize>(grams.names.size() * sizeof(FuzzyIndex::Name)));
+        file.write(reinterpret_cast<const char*>(name_ranges.data()), static_cast<std::streamsize>(name_ranges.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(name_rows.data()), static_cast<std::streamsize>(name_rows.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(grams.keys.data()), static_cast<std::streamsize>(grams.keys.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(grams.offs.data()), static_cast<std::streamsize>(grams.offs.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(grams.postings.data()), static_cast<std::streamsize>(grams.postings.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(norm_names.data()), static_cast<std::streamsize>(norm_names.size() * sizeof(NormName)));
+        file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        file.flush();
+        if (!file.good()) {
+            throw errors::CacheError{"snapshot '" + tmp_path + "' could not be written"};
+        }
+    }
+
+    std::error_code ec;
+
+    // The contents must reach the disk before the rename, otherwise a crash
+    // could leave an empty or partial file under the final name.
+    if (!sync_path(tmp_path, false)) {
+        std::filesystem::remove(tmp_path, ec);
+        throw errors::CacheError{"snapshot '" + tmp_path + "' could not be written"};
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw errors::CacheError{"snapshot '" + path + "' could not be replaced"};
+    }
+
+    // Makes the rename itself durable.
+    const auto dir = std::filesystem::absolute(path, ec).parent_path();
+    if (ec || !sync_path(dir.string(), true)) {
+        throw errors::CacheError{"snapshot '" + path + "' could not be replaced"};
+    }
+}
@@ -47,13 +47,13 @@ void Stmt::bind(const int coln, const Registry value, const std::source_location
     }
 }
 
-void Stmt::bind(const int coln, const std::string& value, const std::source_location loc) {
+void Stmt::bind(const int coln, const std::string_view value, const std::source_location loc) {
     int rc;
 
     if (value.empty()) {
         rc = sqlite3_bind_null(stmt, coln);
     } else {
-        rc = sqlite3_bind_text(stmt, coln, value.c_str(), -1, SQLITE_STATIC);
+        rc = sqlite3_bind_text(stmt, coln, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
     }
 
     if (rc != SQLITE_OK) {
@@ -61,6 +61,14 @@ void Stmt::bind(const int coln, const std::string& value, const std::source_loca
     }
 }
 
+void Stmt::bind_row(const int coln, const VendorView& v) {
+    bind(coln, v.key());
+    bind(coln + 1, v.vendor_name);
+    bind(coln + 2, v.is_private);
+    bind(coln + 3, v.block_type);
+    bind(coln + 4, v.last_update);
+}
+
 void Stmt::clear_bindings(const std::source_location loc) {
     if (const int rc = sqlite3_clear_bindings(stmt); rc != SQLITE_OK) {
         throw errors::CacheError{"__func__", fmt_loc(loc), rc};
@@ -72,8 +80,11 @@ sqlite3_stmt* Stmt::get() const noexcept {
 }
 
 Vendor Stmt::get_row() noexcept {
+    const auto [prefix, len] = split_key(get_col<int64_t>(0));
+
     return Vendor{
-        get_col<int64_t>(0),
+        prefix,
+        static_cast<uint8_t>(len),
         get_col<std::string>(1),
         get_col<bool>(2),
         get_col<Registry>(3),
@@ -81,12 +92,21 @@ Vendor Stmt::get_row() noexcept {
     };
 }
 
-void Stmt::insert_row(const Vendor& v) {
-    bind(1, v.mac_prefix);
-    bind(2, v.vendor_name);
-    bind(3, v.is_private);
-    bind(4, v.block_type);
-    bind(5, v.last_update);
+void Stmt::get_row(VendorList& list) {
+    const auto [prefix, len] = split_key(get_col<int64_t>(0));
+
+    list.emplace_back(
+        prefix,
+        static_cast<uint8_t>(len),
+        get_col<std::string_view>(1),
+        get_col<bool>(2),
+        get_col<Registry>(3),
+        get_col<std::string_view>(4)
+    );
+}
+
+void Stmt::insert_row(const VendorView& v) {
+    bind_row(1, v);
 
     if (const int rc = step(); rc != SQLITE_DONE) {
         throw errors::CacheError{"step", __func__, rc};
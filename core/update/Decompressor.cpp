@@ -0,0 +1,179 @@
+#include <zlib.h>
+
+#if defined(MACPP_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "exception.hpp"
+#include "update/Decompressor.hpp"
+
+class Decompressor::Codec {
+public:
+    virtual ~Codec() = default;
+
+    // Decompresses at most size bytes into out. Returns the number of bytes
+    // written, 0 once all the data has been decompressed. Throws UpdateError
+    // if the data is corrupted or truncated.
+    virtual size_t read(char* out, const size_t size) = 0;
+};
+
+// Decodes gzip data with zlib. Concatenated gzip members are decompressed
+// one after another, as by the gzip utility.
+class Decompressor::GzipCodec : public Decompressor::Codec {
+    z_stream zs;
+
+    // Signals whether the last member has been decompressed.
+    bool done;
+
+public:
+    GzipCodec(const std::string_view data) : zs{}, done{false} {
+        // Window size of 15 bits, +32 accepts both gzip and zlib headers
+        if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+            throw errors::UpdateError{"inflateInit2 failed"};
+        }
+
+        // Input is never written to. Its size is limited to MAX_FSIZE,
+        // which fits uInt.
+        zs.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        zs.avail_in = static_cast<uInt>(data.size());
+    }
+
+    ~GzipCodec() override {
+        inflateEnd(&zs);
+    }
+
+    size_t read(char* out, const size_t size) override {
+        zs.next_out  = reinterpret_cast<Bytef*>(out);
+        zs.avail_out = static_cast<uInt>(size);
+
+        while (zs.avail_out > 0 && !done) {
+            const int rc = inflate(&zs, Z_NO_FLUSH);
+
+            if (rc == Z_STREAM_END) {
+                if (zs.avail_in == 0) {
+                    done = true;
+                } else if (inflateReset(&zs) != Z_OK) {
+                    throw errors::UpdateError{"inflateReset failed"};
+                }
+            } else if (rc == Z_BUF_ERROR && zs.avail_in == 0) {
+                throw errors::UpdateError{"compressed data is truncated"};
+            } else if (rc != Z_OK) {
+                throw errors::UpdateError{"compressed data is corrupted"};
+            }
+        }
+
+        return size - zs.avail_out;
+    }
+};
+
+#if defined(MACPP_ZSTD)
+// Decodes Zstandard data. Concatenated frames are decompressed one after
+// another.
+class Decompressor::ZstdCodec : public Decompressor::Codec {
+    ZSTD_DStream* ds;
+
+    ZSTD_inBuffer in;
+
+    // Result of the last ZSTD_decompressStream call. Zero once a frame
+    // has been decompressed entirely.
+    size_t hint;
+
+public:
+    ZstdCodec(const std::string_view data) : ds{ZSTD_createDStream()}, in{data.data(), data.size(), 0}, hint{1} {
+        if (!ds) {
+            throw errors::UpdateError{"ZSTD_createDStream failed"};
+        }
+    }
+
+    ~ZstdCodec() override {
+        ZSTD_freeDStream(ds);
+    }
+
+    size_t read(char* out, const size_t size) override {
+        ZSTD_outBuffer buf{out, size, 0};
+
+        // Input is exhausted once the last frame is complete
+        while (buf.pos < buf.size && (in.pos < in.size || hint != 0)) {
+            const size_t in_pos  = in.pos;
+            const size_t out_pos = buf.pos;
+
+            hint = ZSTD_decompressStream(ds, &buf, &in);
+
+            if (ZSTD_isError(hint)) {
+                throw errors::UpdateError{std::string{"compressed data is corrupted: "} + ZSTD_getErrorName(hint)};
+            }
+            if (in.pos == in_pos && buf.pos == out_pos) {
+                throw errors::UpdateError{"compressed data is truncated"};
+            }
+        }
+
+        return buf.pos;
+    }
+};
+#endif
+
+Decompressor::Inflater::Inflater(Reader reader)
+    : reader{std::move(reader)}, chunk{std::make_unique<char[]>(CHUNK_SIZE)}, total{0}, stream{this} {
+    // Exceptions thrown by underflow are rethrown by stream only if badbit is set
+    stream.exceptions(std::ios::badbit);
+
+    const std::string_view data = this->reader.data();
+
+    switch (detect(data)) {
+    case Format::Gzip:
+        codec = std::make_unique<GzipCodec>(data);
+        break;
+    case Format::Zstd:
+#if defined(MACPP_ZSTD)
+        codec = std::make_unique<ZstdCodec>(data);
+        break;
+#else
+        throw errors::UpdateError{"Zstandard compression is not supported by this build"};
+#endif
+    default:
+        throw errors::UpdateError{"unknown compression format"};
+    }
+}
+
+Decompressor::Inflater::~Inflater() = default;
+
+Decompressor::Inflater::int_type Decompressor::Inflater::underflow() {
+    const size_t n = codec->read(chunk.get(), CHUNK_SIZE);
+
+    if (n == 0) {
+        return traits_type::eof();
+    }
+
+    total += n;
+    if (total > MAX_FSIZE) {
+        throw errors::UpdateError{"file size limit exceeded during decompression"};
+    }
+
+    setg(chunk.get(), chunk.get(), chunk.get() + n);
+
+    return traits_type::to_int_type(chunk[0]);
+}
+
+Decompressor::Decompressor(Reader reader) : inflater{std::make_unique<Inflater>(std::move(reader))} {}
+
+Decompressor::Format Decompressor::detect(const std::string_view data) noexcept {
+    if (data.starts_with("\x1f\x8b")) {
+        return Format::Gzip;
+    }
+    if (data.starts_with("\x28\xb5\x2f\xfd")) {
+        return Format::Zstd;
+    }
+    return Format::None;
+}
+
+std::istream& Decompressor::get() noexcept {
+    return inflater->stream;
+}
+
+bool Decompressor::supports(const Format format) noexcept {
+#if defined(MACPP_ZSTD)
+    return format != Format::None;
+#else
+    return format == Format::Gzip;
+#endif
+}
@@ -1,66 +1,192 @@
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <string_view>
+
 #include "update/Downloader.hpp"
 #include "exception.hpp"
 
 std::once_flag Downloader::curl_init{};
 
-Downloader::Downloader(const std::string& url) {
+// Returns the value of header line if its field name equals name, ignoring
+// case. Whitespace around the value is removed.
+static std::optional<std::string_view> header_value(std::string_view line, const std::string_view name) {
+    if (line.size() <= name.size() || line[name.size()] != ':') {
+        return std::nullopt;
+    }
+
+    const bool equal = std::equal(name.begin(), name.end(), line.begin(), [](const char a, const char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+
+    if (!equal) {
+        return std::nullopt;
+    }
+
+    line.remove_prefix(name.size() + 1);
+
+    const size_t first = line.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return std::string_view{};
+    }
+
+    return line.substr(first, line.find_last_not_of(" \t\r\n") + 1 - first);
+}
+
+Downloader::Transfer::Transfer(CURL* curl)
+    : curl{curl}, headers{nullptr}, chunks{QUEUED_CHUNKS}, result{CURLE_OK}, size{0}, status{0}, buf{chunks, result}, stream{&buf} {
+    // Exceptions thrown by buf are rethrown by stream only if badbit is set
+    stream.exceptions(std::ios::badbit);
+}
+
+Downloader::Transfer::~Transfer() {
+    // Makes write_data and progress abort the transfer
+    chunks.close();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+}
+
+Downloader::ChunkBuf::int_type Downloader::ChunkBuf::underflow() {
+    std::optional<std::string> next = chunks.pop();
+
+    if (!next) {
+        if (result == CURLE_FILESIZE_EXCEEDED) {
+            throw errors::UpdateError{"file size limit exceeded during download"};
+        } else if (result != CURLE_OK) {
+            throw errors::UpdateError{"curl_easy_perform failed", result};
+        }
+        return traits_type::eof();
+    }
+
+    chunk = std::move(*next);
+    setg(chunk.data(), chunk.data(), chunk.data() + chunk.size());
+
+    return traits_type::to_int_type(chunk.front());
+}
+
+Downloader::Downloader(const std::string& url, const Validators& cached, const long stall_timeout) {
     std::call_once(curl_init, [&] {
         if (const CURLcode rc = curl_global_init(CURL_GLOBAL_DEFAULT); rc != CURLE_OK) {
             throw errors::UpdateError{"curl_global_init failed", rc};
         }
     });
 
-    if (!(curl = curl_easy_init())) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
         throw errors::UpdateError{"curl_easy_init failed"};
     }
 
+    transfer = std::make_unique<Transfer>(curl);
+
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
     curl_easy_setopt(curl, CURLOPT_MAXFILESIZE, MAX_FSIZE);
 
+    // A stalled server would otherwise block the reader, and the threads
+    // joined after it, indefinitely
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, stall_timeout);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, transfer.get());
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    // Every encoding supported by libcurl is accepted. The response
+    // is decoded before it reaches write_data.
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &data);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, read_header);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->received);
 
-    if (const CURLcode rc = curl_easy_perform(curl); rc != CURLE_OK) {
-        curl_easy_cleanup(curl);
-
-        if (rc == CURLE_FILESIZE_EXCEEDED) {
-            throw errors::UpdateError{"file size limit exceeded during download"};
+    // A server that ignores either header sends the whole response
+    const auto add_header = [&](const std::string& header) {
+        curl_slist* headers = curl_slist_append(transfer->headers, header.c_str());
+        if (!headers) {
+            throw errors::UpdateError{"curl_slist_append failed"};
         }
+        transfer->headers = headers;
+    };
 
-        throw errors::UpdateError{"curl_easy_perform failed", rc};
+    if (!cached.etag.empty()) {
+        add_header("If-None-Match: " + cached.etag);
+    }
+    if (!cached.last_modified.empty()) {
+        add_header("If-Modified-Since: " + cached.last_modified);
     }
+
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+
+    transfer->thread = std::thread{[t = transfer.get()] {
+        t->result = curl_easy_perform(t->curl);
+
+        // MAXFILESIZE limits the encoded size only
+        if (t->size > MAX_FSIZE) {
+            t->result = CURLE_FILESIZE_EXCEEDED;
+        }
+
+        curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &t->status);
+        t->chunks.close();
+    }};
+}
+
+std::istream& Downloader::get() noexcept {
+    return transfer->stream;
 }
 
-Downloader::Downloader(Downloader&& other) : curl{other.curl}, data{std::move(other.data)} {
-    other.curl = nullptr;
+bool Downloader::not_modified() const noexcept {
+    return transfer->result == CURLE_OK && transfer->status == 304;
 }
 
-Downloader& Downloader::operator=(Downloader&& other) {
-    if (this != &other) {
-        curl_easy_cleanup(curl);
-        curl       = other.curl;
-        other.curl = nullptr;
+const Downloader::Validators& Downloader::validators() const noexcept {
+    return transfer->received;
+}
 
-        data = std::move(other.data);
-    }
-    return *this;
+int Downloader::progress(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    // Returning a non-zero value aborts the transfer
+    return static_cast<Transfer*>(clientp)->chunks.is_closed() ? 1 : 0;
 }
 
-Downloader::~Downloader() {
-    if (curl) {
-        curl_easy_cleanup(curl);
+size_t Downloader::read_header(char* buffer, size_t size, size_t nitems, void* userp) {
+    auto* received = static_cast<Validators*>(userp);
+
+    const std::string_view line{buffer, size * nitems};
+
+    if (line.starts_with("HTTP/")) {
+        // Status line of the next response
+        *received = Validators{};
+    } else if (const auto etag = header_value(line, "ETag")) {
+        received->etag = *etag;
+    } else if (const auto last_modified = header_value(line, "Last-Modified")) {
+        received->last_modified = *last_modified;
     }
-}
 
-std::istream& Downloader::get() noexcept {
-    return data;
+    return size * nitems;
 }
 
 size_t Downloader::write_data(void* buffer, size_t size, size_t nmemb, void* userp) {
-    std::stringstream* data = static_cast<std::stringstream*>(userp);
+    auto* t = static_cast<Transfer*>(userp);
+
+    if (size * nmemb == 0) {
+        return 0;
+    }
 
-    data->write(static_cast<char*>(buffer), static_cast<std::streamsize>(size * nmemb));
+    // Returning a value other than the number of bytes received aborts
+    // the transfer
+    if ((t->size += size * nmemb) > MAX_FSIZE) {
+        return 0;
+    }
+
+    // A closed channel means the reader is gone
+    if (!t->chunks.push(std::string{static_cast<char*>(buffer), size * nmemb})) {
+        return 0;
+    }
     return size * nmemb;
 }
@@ -1,18 +1,113 @@
-#include <filesystem>
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "exception.hpp"
 #include "update/Reader.hpp"
 
-Reader::Reader(const std::string& path) : file{std::ifstream{path}} {
-    if (!file.good()) {
+Reader::Mapping::Mapping(const std::string& path) : data{nullptr}, size{0}, stream{this} {
+#if defined(_WIN32)
+    handle = nullptr;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
         throw errors::Error{"file '" + path + "' not found"};
     }
 
-    if (std::filesystem::file_size(path) > MAX_FSIZE) {
+    LARGE_INTEGER fsize;
+    if (!GetFileSizeEx(file, &fsize)) {
+        CloseHandle(file);
+        throw errors::UpdateError{"file '" + path + "' could not be mapped"};
+    }
+
+    if (fsize.QuadPart > static_cast<LONGLONG>(MAX_FSIZE)) {
+        CloseHandle(file);
+        throw errors::UpdateError{"file '" + path + "' exceeds local file size limit"};
+    }
+    size = static_cast<size_t>(fsize.QuadPart);
+
+    // Empty files cannot be mapped
+    if (size > 0) {
+        handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+
+        if (!handle) {
+            throw errors::UpdateError{"file '" + path + "' could not be mapped"};
+        }
+
+        if (!(data = static_cast<const char*>(MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0)))) {
+            CloseHandle(handle);
+            throw errors::UpdateError{"file '" + path + "' could not be mapped"};
+        }
+    } else {
+        CloseHandle(file);
+    }
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw errors::Error{"file '" + path + "' not found"};
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw errors::UpdateError{"file '" + path + "' could not be mapped"};
+    }
+
+    if (st.st_size > static_cast<off_t>(MAX_FSIZE)) {
+        close(fd);
         throw errors::UpdateError{"file '" + path + "' exceeds local file size limit"};
     }
+    size = static_cast<size_t>(st.st_size);
+
+    // Empty files cannot be mapped
+    if (size > 0) {
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (addr == MAP_FAILED) {
+            throw errors::UpdateError{"file '" + path + "' could not be mapped"};
+        }
+        data = static_cast<const char*>(addr);
+
+        // The file is parsed front to back
+        madvise(addr, size, MADV_SEQUENTIAL);
+    } else {
+        close(fd);
+    }
+#endif
+
+    // The get area is never written to
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+Reader::Mapping::~Mapping() {
+    if (!data) {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(handle);
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+}
+
+Reader::Reader(const std::string& path) : mapping{std::make_unique<Mapping>(path)} {}
+
+std::string_view Reader::data() const noexcept {
+    return {mapping->data, mapping->size};
 }
 
 std::istream& Reader::get() noexcept {
-    return file;
+    return mapping->stream;
 }
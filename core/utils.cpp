@@ -1,13 +1,14 @@
 #include <algorithm>
-#include <charconv>
+#include <array>
+#include <limits>
 #include <sstream>
-#include <system_error>
 
+#include "FuzzyIndex.hpp"
 #include "exception.hpp"
 #include "utils.hpp"
 
 std::string build_find_by_addr_stmt(const size_t length) noexcept {
-    std::string stmt = "SELECT * FROM vendors WHERE prefix IN (?";
+    std::string stmt = "SELECT * FROM vendor_rows WHERE prefix IN (?";
 
     // Start from 1, since the first placeholder is appended beforehand.
     for (size_t i = 1; i < length; i++) {
@@ -18,26 +19,23 @@ std::string build_find_by_addr_stmt(const size_t length) noexcept {
     return stmt;
 }
 
-std::vector<int64_t> construct_queries(const std::string& addr) {
+Queries construct_queries(const MacAddr& addr) {
     constexpr size_t VENDOR_BLOCK_LENGTHS[3] = {6, 7, 9};
 
-    std::vector<int64_t> queries;
-    queries.reserve(4);
-
-    std::optional<std::string> ieee_block;
+    Queries queries;
 
     for (const auto& block_len : VENDOR_BLOCK_LENGTHS) {
-        ieee_block = get_ieee_block(addr, block_len);
-
-        if (ieee_block) {
-            queries.push_back(prefix_to_int(*ieee_block));
+        if (addr.len >= block_len) {
+            queries.push_back(make_key(addr.value >> (4 * (MAC_NIBBLES - block_len)), block_len));
         }
     }
 
     // Edge case: check for Docker's prefix (02:42)
-    if (addr.starts_with("0242")) {
-        if (std::ranges::find(queries, 0x024200) == queries.end()) {
-            queries.push_back(0x024200);
+    if (addr.len >= 4 && (addr.value >> (4 * (MAC_NIBBLES - 4))) == 0x0242) {
+        constexpr int64_t DOCKER_KEY = make_key(0x024200, 6);
+
+        if (std::ranges::find(queries, DOCKER_KEY) == queries.end()) {
+            queries.push_back(DOCKER_KEY);
         }
     }
 
@@ -48,47 +46,222 @@ std::vector<int64_t> construct_queries(const std::string& addr) {
     return queries;
 }
 
-std::optional<std::string> get_ieee_block(const std::string& addr, const size_t block_len) {
-    if (addr.length() >= block_len) {
-        return addr.substr(0, block_len);
+Queries construct_queries(const std::string_view addr) {
+    return construct_queries(parse_addr(addr));
+}
+
+bool like_match(std::string_view str, std::string_view pattern) noexcept {
+    constexpr char ANY_SEQ  = '%';
+    constexpr char ANY_CHAR = '_';
+    constexpr char ESCAPE   = '\\';
+
+    const auto fold = [](const char c) -> char {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    };
+
+    // Returns the position of the UTF-8 character following the one at pos.
+    const auto next_char = [&str](size_t pos) -> size_t {
+        do {
+            pos++;
+        } while (pos < str.size() && (static_cast<unsigned char>(str[pos]) & 0xC0) == 0x80);
+        return pos;
+    };
+
+    size_t s = 0, p = 0;
+
+    // Positions to resume from after a mismatch following the last '%'
+    size_t seq_s = 0, seq_p = std::string_view::npos;
+
+    while (s < str.size()) {
+        if (p < pattern.size()) {
+            if (pattern[p] == ANY_SEQ) {
+                seq_p = ++p;
+                seq_s = s;
+                continue;
+            }
+
+            if (pattern[p] == ANY_CHAR) {
+                s = next_char(s);
+                p++;
+                continue;
+            }
+
+            const size_t lit = (pattern[p] == ESCAPE) ? p + 1 : p;
+
+            if (lit < pattern.size() && fold(pattern[lit]) == fold(str[s])) {
+                s++;
+                p = lit + 1;
+                continue;
+            }
+        }
+
+        if (seq_p == std::string_view::npos) {
+            return false;
+        }
+
+        // Let the last '%' absorb one more character and retry
+        seq_s = next_char(seq_s);
+        s     = seq_s;
+        p     = seq_p;
     }
-    return std::nullopt;
+
+    while (p < pattern.size() && pattern[p] == ANY_SEQ) {
+        p++;
+    }
+
+    return p == pattern.size();
 }
 
-int64_t prefix_to_int(const std::string& prefix) {
-    std::string clean = remove_addr_separators(prefix);
+std::vector<std::string> like_literals(const std::string_view pattern) {
+    constexpr char ANY_SEQ  = '%';
+    constexpr char ANY_CHAR = '_';
+    constexpr char ESCAPE   = '\\';
 
-    int64_t conv{};
+    std::vector<std::string> runs;
+    std::string              run;
 
-    const auto [ptr, ec] = std::from_chars(
-        clean.data(),
-        clean.data() + clean.size(),
-        conv,
-        16
-    );
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
 
-    if (ec == std::errc::invalid_argument) {
-        throw errors::Error{"specified MAC address contains invalid characters"};
-    } else if (ec == std::errc::result_out_of_range) {
-        throw errors::Error{"specified MAC address is too large"};
-    } else if (ec != std::errc{}) {
-        throw errors::Error{"unexpected error encountered during MAC address parsing (" + std::make_error_code(ec).message() + ')'};
+        if (c == ANY_SEQ || c == ANY_CHAR) {
+            if (!run.empty()) {
+                runs.push_back(std::move(run));
+                run.clear();
+            }
+            continue;
+        }
+
+        if (c == ESCAPE) {
+            if (++i == pattern.size()) {
+                break;
+            }
+            c = pattern[i];
+        }
+
+        run += c;
+    }
+
+    if (!run.empty()) {
+        runs.push_back(std::move(run));
+    }
+
+    return runs;
+}
+
+std::string normalize_name(const std::string_view name) {
+    // Legal form designations, in normalized form
+    constexpr std::array<std::string_view, 24> SUFFIXES = {
+        "ab", "ag", "bv", "co", "company", "corp", "corporation", "gmbh",
+        "inc", "incorporated", "kg", "limited", "llc", "ltd", "nv", "oy",
+        "plc", "pte", "pty", "pvt", "sa", "sas", "spa", "srl",
+    };
+
+    std::string norm = FuzzyIndex::normalize(name);
+
+    // Suffixes are stripped one by one ("co ltd"), but the first word
+    // of the name is always kept.
+    for (size_t sep; (sep = norm.rfind(' ')) != std::string::npos;) {
+        if (std::ranges::find(SUFFIXES, std::string_view{norm}.substr(sep + 1)) == SUFFIXES.end()) {
+            break;
+        }
+        norm.resize(sep);
+    }
+
+    return norm;
+}
+
+MacAddr parse_addr(const std::string_view addr) {
+    static constexpr uint8_t SEP     = 0x10;
+    static constexpr uint8_t INVALID = 0xFF;
+
+    // Maps every character to its hex value, SEP or INVALID
+    constexpr auto TABLE = [] {
+        std::array<uint8_t, 256> table{};
+        table.fill(INVALID);
+
+        for (uint8_t i = 0; i < 10; i++) {
+            table['0' + i] = i;
+        }
+        for (uint8_t i = 0; i < 6; i++) {
+            table['A' + i] = static_cast<uint8_t>(10 + i);
+            table['a' + i] = static_cast<uint8_t>(10 + i);
+        }
+
+        table[':'] = SEP;
+        table['-'] = SEP;
+        table['.'] = SEP;
+
+        return table;
+    }();
+
+    MacAddr mac{0, 0};
+
+    for (const char c : addr) {
+        const uint8_t nibble = TABLE[static_cast<unsigned char>(c)];
+
+        if (nibble == SEP) {
+            continue;
+        }
+
+        if (nibble == INVALID) {
+            throw errors::Error{"specified MAC address contains invalid characters"};
+        }
+
+        if (mac.len < MAC_NIBBLES) {
+            mac.value = mac.value << 4 | nibble;
+            mac.len++;
+        }
     }
 
-    if (static_cast<size_t>(ptr - clean.data()) != clean.size()) {
+    mac.value <<= 4 * (MAC_NIBBLES - mac.len);
+
+    return mac;
+}
+
+int64_t prefix_to_int(const std::string_view prefix) {
+    constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+
+    // Sign is accepted to report negative prefixes, like std::from_chars
+    const bool negative = prefix.starts_with('-');
+
+    int64_t conv   = 0;
+    size_t  digits = 0;
+
+    for (const char c : prefix.substr(negative ? 1 : 0)) {
+        int64_t nibble;
+
+        if (c == ':') {
+            continue;
+        } else if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else {
+            throw errors::Error{"specified MAC address contains invalid characters"};
+        }
+
+        if (conv > (MAX - nibble) / 16) {
+            throw errors::Error{"specified MAC address is too large"};
+        }
+
+        conv = conv * 16 + nibble;
+        digits++;
+    }
+
+    if (digits == 0) {
         throw errors::Error{"specified MAC address contains invalid characters"};
     }
 
-    if (conv < 0) {
+    if (negative && conv != 0) {
         throw errors::Error{"specified MAC address is negative"};
     }
 
     return conv;
 }
 
-std::string prefix_to_string(const int64_t prefix) {
-    constexpr size_t MIN_PREFIX_LEN = 6;
-
+std::string prefix_to_string(const int64_t prefix, const size_t len) {
     std::ostringstream ss;
     ss << std::uppercase << std::hex << prefix;
 
@@ -97,8 +270,8 @@ std::string prefix_to_string(const int64_t prefix) {
     ss.str("");
     ss.clear();
 
-    if (hex_str.size() < MIN_PREFIX_LEN) {
-        hex_str.insert(0, MIN_PREFIX_LEN - hex_str.size(), '0');
+    if (hex_str.size() < len) {
+        hex_str.insert(0, len - hex_str.size(), '0');
     }
 
     for (size_t i = 0; i < hex_str.size(); i++) {
@@ -111,12 +284,6 @@ std::string prefix_to_string(const int64_t prefix) {
     return ss.str();
 }
 
-std::string remove_addr_separators(const std::string& addr) {
-    std::string stripped = addr;
-    stripped.erase(std::remove(stripped.begin(), stripped.end(), ':'), stripped.end());
-    return stripped;
-}
-
 void replace_escaped_quotes(std::string& str) {
     constexpr std::string_view target      = "\"\"";
     constexpr std::string_view replacement = "\"";
@@ -128,3 +295,59 @@ void replace_escaped_quotes(std::string& str) {
         pos += replacement.length();
     }
 }
+
+std::vector<std::string_view> split_lines(const std::string_view text, const size_t n) {
+    std::vector<std::string_view> blocks;
+
+    const size_t count = std::max(n, size_t{1});
+
+    size_t begin = 0;
+
+    for (size_t b = 1; b <= count && begin < text.size(); b++) {
+        size_t end = text.size();
+
+        if (b < count) {
+            // Extend the block to the end of the line containing its nominal end
+            end = std::max(begin + 1, text.size() * b / count);
+            end = std::min(text.find('\n', end - 1), text.size() - 1) + 1;
+        }
+
+        blocks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    return blocks;
+}
+
+std::string trigram_query(const std::string_view pattern) {
+    // Trigram index cannot look up shorter strings
+    constexpr size_t MIN_CHARS = 3;
+
+    std::string query;
+
+    for (const auto& run : like_literals(pattern)) {
+        // Continuation bytes of UTF-8 characters are not counted
+        const auto chars = std::ranges::count_if(run, [](const char c) {
+            return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+        });
+
+        if (chars < static_cast<std::ptrdiff_t>(MIN_CHARS)) {
+            continue;
+        }
+
+        if (!query.empty()) {
+            query += " AND ";
+        }
+
+        query += '"';
+        for (const char c : run) {
+            query += c;
+            if (c == '"') {
+                query += '"';
+            }
+        }
+        query += '"';
+    }
+
+    return query;
+}
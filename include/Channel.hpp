@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Bounded queue that passes items between a producer and a consumer thread.
+// Producer blocks while the queue is full, consumer blocks while it is empty.
+// Either side may close the channel: the producer to signal the end of data,
+// the consumer to stop the producer.
+template <class T>
+class Channel {
+    std::mutex              mtx;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+    std::deque<T> items;
+
+    // Maximum number of items held by the queue.
+    const size_t capacity;
+
+    // Signals whether close has been called.
+    bool closed;
+
+public:
+    explicit Channel(const size_t capacity) : capacity{capacity > 0 ? capacity : 1}, closed{false} {}
+
+    Channel(const Channel&)            = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    // Closes the channel. Blocked push and pop calls return. Items already
+    // in the queue can still be popped.
+    void close() noexcept {
+        {
+            const std::lock_guard lock{mtx};
+            closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    // Returns true if close has been called.
+    bool is_closed() noexcept {
+        const std::lock_guard lock{mtx};
+        return closed;
+    }
+
+    // Removes the first item from the queue, waiting for one to arrive
+    // if it is empty. Returns std::nullopt once the channel is closed
+    // and all items have been popped.
+    std::optional<T> pop() {
+        std::unique_lock lock{mtx};
+        not_empty.wait(lock, [&] { return !items.empty() || closed; });
+
+        if (items.empty()) {
+            return std::nullopt;
+        }
+
+        std::optional<T> item{std::move(items.front())};
+        items.pop_front();
+
+        lock.unlock();
+        not_full.notify_one();
+
+        return item;
+    }
+
+    // Appends item to the queue, waiting for space if it is full.
+    // Returns false if the channel has been closed, in which case
+    // the item is discarded.
+    bool push(T item) {
+        std::unique_lock lock{mtx};
+        not_full.wait(lock, [&] { return items.size() < capacity || closed; });
+
+        if (closed) {
+            return false;
+        }
+
+        items.push_back(std::move(item));
+
+        lock.unlock();
+        not_empty.notify_one();
+
+        return true;
+    }
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Trigram inverted index of distinct vendor names, used to find names
+// similar to a misspelled search term. The index is built once, at update
+// time, and stored in flat tables that can be memory-mapped (see Snapshot).
+//
+// Names and search terms are normalized before trigrams are extracted:
+// ASCII letters are folded to lower case and runs of other ASCII characters
+// that are not digits are collapsed into a single space. Normalized strings
+// are padded with a space on both ends, so that trigrams also mark the word
+// boundaries.
+//
+// Names sharing enough trigrams with the search term are candidates.
+// Candidates are ranked by the edit distance between the term and the most
+// similar part of the name, which is bounded by the term length, then by
+// trigram similarity and finally by name.
+class FuzzyIndex {
+public:
+    // Name stored at off in the strings blob, with the number of distinct
+    // trigrams it contains.
+    struct Name {
+        uint32_t off;
+        uint32_t len;
+        uint32_t grams;
+    };
+
+    // Owning storage of the index tables.
+    struct Tables {
+        std::vector<Name>     names;
+        std::vector<uint32_t> keys;
+        std::vector<uint32_t> offs;
+        std::vector<uint32_t> postings;
+    };
+
+    // Greatest edit distance accepted for a search term.
+    static constexpr size_t MAX_DISTANCE = 2;
+
+private:
+    // Blob containing the names.
+    std::string_view strings;
+
+    // Indexed names. Search results are positions in this table.
+    std::span<const Name> names;
+
+    // Distinct trigrams, sorted ascending. Postings of keys[i] are stored
+    // between offs[i] and offs[i + 1].
+    std::span<const uint32_t> keys;
+    std::span<const uint32_t> offs;
+
+    // Positions of the names containing each trigram, sorted ascending.
+    std::span<const uint32_t> postings;
+
+    // Returns the sorted, distinct trigrams of normalized string s.
+    static std::vector<uint32_t> grams_of(std::string_view s);
+
+    // Positions of every byte in a term of up to 64 characters, as bit masks.
+    using Masks = std::array<uint64_t, 256>;
+
+    // Returns the edit distance between normalized term and the closest
+    // substring of text, normalized. Masks describe the first 64 characters
+    // of term.
+    static size_t distance(std::string_view term, const Masks& masks, std::string_view text);
+
+public:
+    // Creates a view of the tables. Name offsets refer to strings.
+    FuzzyIndex(
+        std::string_view          strings,
+        std::span<const Name>     names,
+        std::span<const uint32_t> keys,
+        std::span<const uint32_t> offs,
+        std::span<const uint32_t> postings
+    ) noexcept;
+
+    // Creates a view of tables built by build.
+    FuzzyIndex(std::string_view strings, const Tables& tables) noexcept;
+
+    // Builds the tables of names. The grams member of every name is filled.
+    // Throws Error if the index would exceed 32-bit offsets.
+    static Tables build(std::string_view strings, std::vector<Name> names);
+
+    // Returns the positions of at most top names closest to term, from
+    // the best match. Throws CacheError if the tables are inconsistent.
+    std::vector<uint32_t> find(std::string_view term, size_t top) const;
+
+    // Returns s with ASCII letters folded to lower case and runs of other
+    // characters that are neither digits nor non-ASCII bytes collapsed into
+    // a single space. Leading and trailing spaces are removed.
+    static std::string normalize(std::string_view s);
+};
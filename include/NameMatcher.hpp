@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Matches vendor names against any number of search terms in a single pass.
+// Terms are LIKE patterns (see like_match) that may occur anywhere within
+// a name. Terms without wildcards are compiled into an Aho-Corasick
+// automaton over ASCII case-folded bytes, so that the cost of matching
+// a name does not depend on the number of terms. Terms with wildcards
+// are matched with like_match one by one.
+class NameMatcher {
+    // Maps every byte to its input class. Bytes absent from the terms
+    // share class 0, upper case ASCII letters share the class of their
+    // lower case counterparts.
+    std::array<uint32_t, 256> classes;
+
+    // Number of input classes.
+    uint32_t n_classes;
+
+    // Complete transition function of the automaton, indexed by
+    // state * n_classes + class. State 0 is the root.
+    std::vector<uint32_t> delta;
+
+    // Ids of the terms recognized in each state, including those inherited
+    // through failure links. Terms of state s are stored in out_terms
+    // between out_offs[s] and out_offs[s + 1].
+    std::vector<uint32_t> out_offs;
+    std::vector<uint32_t> out_terms;
+
+    // Terms with wildcards, as <id, '%' + term + '%'> pairs.
+    std::vector<std::pair<uint32_t, std::string>> patterns;
+
+public:
+    // Number of terms from which a single pass over every name is expected
+    // to outperform searching the database for each term separately.
+    static constexpr size_t MIN_TERMS = 16;
+
+    // Compiles the terms. Term ids are their positions in terms.
+    explicit NameMatcher(std::span<const std::string> terms);
+
+    // Returns true if name matches any of the terms.
+    bool matches(std::string_view name) const;
+
+    // Returns the ids of the terms matched by name, in ascending order.
+    std::vector<uint32_t> match(std::string_view name) const;
+};
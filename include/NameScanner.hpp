@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NameMatcher.hpp"
+
+// Searches vendor names for terms that may occur anywhere within a name.
+// Terms are LIKE patterns (see like_match). Names are kept in a single
+// arena, along with an offset array. Every term is searched for by its
+// longest literal run with a vectorized first/last-byte filter, and only
+// the candidates are verified. Long lists of terms are matched in a single
+// pass with NameMatcher. The arena is split into chunks of similar size,
+// scanned in parallel.
+class NameScanner {
+    // Term prepared for a vectorized scan. Defined in the source file.
+    struct Term;
+
+    // Names as given, each terminated with '\0'.
+    std::string names;
+
+    // Names folded to ASCII lower case, at the same positions as in names.
+    // The terminators ensure that no match spans two names.
+    std::string folded;
+
+    // Position of every name in names and folded, followed by their size.
+    std::vector<uint32_t> offs;
+
+    // Name positions that divide folded into chunks of similar size.
+    // Begins with 0 and ends with the number of names.
+    std::vector<uint32_t> chunks;
+
+    // Returns the name at position i.
+    std::string_view name(const size_t i) const noexcept;
+
+    // Returns the position of the first occurrence of needle in haystack,
+    // starting at pos, or std::string_view::npos. Candidate positions
+    // are found 16 at a time by comparing the first and the last byte
+    // of needle, and only these are verified.
+    static size_t find_folded(std::string_view haystack, std::string_view needle, size_t pos) noexcept;
+
+    // Appends to found the positions of names within chunk c matching
+    // pattern. Needle is the longest literal run of the pattern, folded.
+    // Every match contains it. Plain patterns contain no wildcards
+    // and are matched by needle alone.
+    void scan_chunk(const size_t c, const std::string& pattern, std::string_view needle, const bool plain, std::vector<uint32_t>& found) const;
+
+    // Appends to found the positions of names within chunk c matched
+    // by matcher.
+    void scan_chunk(const size_t c, const NameMatcher& matcher, std::vector<uint32_t>& found) const;
+
+    // Appends the positions of names within chunk c matched by matcher
+    // to the lists in found of the terms they match, by term id.
+    void scan_chunk(const size_t c, const NameMatcher& matcher, std::vector<std::vector<uint32_t>>& found) const;
+
+    // Prepares terms for scan_chunk.
+    static std::vector<Term> parse_terms(std::span<const std::string> terms);
+
+    // Calls scan for every chunk, on separate threads.
+    void scan_chunks(const std::function<void(size_t)>& scan) const;
+
+public:
+    // Number of terms from which a single pass with NameMatcher outperforms
+    // a vectorized scan for each term. A scan for a single term costs
+    // a fraction of a pass with NameMatcher, so the automaton pays off later
+    // than against the database.
+    static constexpr size_t MIN_MATCHER_TERMS = 2 * NameMatcher::MIN_TERMS;
+
+    // Copies names into the arena. Scans are split across threads,
+    // by default one per hardware thread.
+    explicit NameScanner(std::span<const std::string_view> names, size_t threads = 0);
+
+    // Returns the positions of the names matching any of the terms,
+    // in ascending order. Empty names never match. Terms must not be empty.
+    std::vector<uint32_t> find(std::span<const std::string> terms) const;
+
+    // Returns the positions of the names matching each of the terms,
+    // in ascending order, by term position. A name matching several terms
+    // is listed for each of them. Empty names never match. Terms must not
+    // be empty.
+    std::vector<std::vector<uint32_t>> find_each(std::span<const std::string> terms) const;
+
+    // Returns the number of names.
+    size_t size() const noexcept;
+};
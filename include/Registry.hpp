@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 // Represents registry to which the assigned MAC address block belongs.
-enum class Registry {
+enum class Registry : uint8_t {
     Unknown,
     CID,
     IAB,
@@ -16,4 +18,4 @@ enum class Registry {
 std::string from_registry(const Registry registry) noexcept;
 
 // Converts string to Registry value.
-Registry to_registry(const std::string& registry) noexcept;
+Registry to_registry(const std::string_view registry) noexcept;
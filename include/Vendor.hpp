@@ -1,32 +1,80 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Registry.hpp"
+#include "utils.hpp"
+
+struct VendorView;
 
 struct Vendor {
     int64_t     mac_prefix;
+    uint8_t     prefix_len;
     std::string vendor_name;
     bool        is_private;
     Registry    block_type;
     std::string last_update;
 
     // Creates a Vendor struct from a comma-separated CSV line.
-    Vendor(const std::string& line);
+    // Throws ParsingError subclass if the line is malformed.
+    Vendor(const std::string_view line);
+
+    // Creates a Vendor struct that owns copies of the fields of v.
+    explicit Vendor(const VendorView& v);
 
     constexpr Vendor(
         const int64_t  mac_prefix,
+        const uint8_t  prefix_len,
         std::string    vendor_name,
         const bool     is_private,
         const Registry block_type,
         std::string    last_update
     ) noexcept : mac_prefix{mac_prefix},
+                 prefix_len{prefix_len},
                  vendor_name{std::move(vendor_name)},
                  is_private{is_private},
                  block_type{block_type},
                  last_update{std::move(last_update)} {}
 
+    // Creates a Vendor struct with prefix length derived from block_type.
+    constexpr Vendor(
+        const int64_t  mac_prefix,
+        std::string    vendor_name,
+        const bool     is_private,
+        const Registry block_type,
+        std::string    last_update
+    ) noexcept : Vendor{mac_prefix, default_prefix_len(mac_prefix, block_type), std::move(vendor_name), is_private, block_type, std::move(last_update)} {}
+
+    // Returns the number of hex digits in a prefix of the given block type.
+    // For blocks of unknown type, the number of digits required to represent
+    // mac_prefix is returned, but no fewer than 6.
+    static constexpr uint8_t default_prefix_len(const int64_t mac_prefix, const Registry block_type) noexcept {
+        switch (block_type) {
+        case Registry::CID:
+        case Registry::MA_L: return 6;
+        case Registry::MA_M: return 7;
+        case Registry::IAB:
+        case Registry::MA_S: return 9;
+        default:             break;
+        }
+
+        uint8_t len = 6;
+        while (len < MAC_NIBBLES && (mac_prefix >> (4 * len)) != 0) {
+            len++;
+        }
+        return len;
+    }
+
+    // Returns the cache key of the Vendor, as created by make_key.
+    constexpr int64_t key() const noexcept {
+        return make_key(mac_prefix, prefix_len);
+    }
+
     // Formats Vendor data into CSV line and writes it to os.
     std::ostream& write_string_csv(std::ostream& os) const noexcept;
 
@@ -45,3 +93,72 @@ struct Vendor {
 
     friend std::ostream& operator<<(std::ostream& os, const Vendor& v);
 };
+
+// Vendor record parsed from a CSV line without copying its fields.
+// String fields view the parsed line, so they remain valid as long as
+// the line does. Vendor names containing escaped quotes are the exception:
+// they are unescaped into a buffer supplied by the caller.
+struct VendorView {
+    int64_t          mac_prefix;
+    uint8_t          prefix_len;
+    std::string_view vendor_name;
+    bool             is_private;
+    Registry         block_type;
+    std::string_view last_update;
+
+    // Parses a comma-separated CSV line. If the vendor name contains escaped
+    // quotes, it is unescaped into buf and vendor_name views buf
+    // until it is modified. Throws ParsingError subclass if the line
+    // is malformed.
+    VendorView(const std::string_view line, std::string& buf);
+
+    constexpr VendorView(
+        const int64_t          mac_prefix,
+        const uint8_t          prefix_len,
+        const std::string_view vendor_name,
+        const bool             is_private,
+        const Registry         block_type,
+        const std::string_view last_update
+    ) noexcept : mac_prefix{mac_prefix},
+                 prefix_len{prefix_len},
+                 vendor_name{vendor_name},
+                 is_private{is_private},
+                 block_type{block_type},
+                 last_update{last_update} {}
+
+    // Views the fields of v.
+    VendorView(const Vendor& v) noexcept
+        : mac_prefix{v.mac_prefix},
+          prefix_len{v.prefix_len},
+          vendor_name{v.vendor_name},
+          is_private{v.is_private},
+          block_type{v.block_type},
+          last_update{v.last_update} {}
+
+    // Returns the cache key of the record, as created by make_key.
+    constexpr int64_t key() const noexcept {
+        return make_key(mac_prefix, prefix_len);
+    }
+
+    // Returns a 64-bit FNV-1a hash of the fields of the record other than
+    // its prefix. Used to find the records changed by an update.
+    int64_t hash() const noexcept;
+};
+
+// Vendor records parsed in place from a block of CSV lines. Rows view
+// the block, which must outlive them, or the unescaped vendor names owned
+// by the VendorBlock. Moving a VendorBlock keeps the rows valid.
+struct VendorBlock {
+    std::vector<VendorView> rows;
+
+    // Vendor names of the rows that contained escaped quotes.
+    std::deque<std::string> unescaped;
+
+    // Parses newline-separated CSV lines contained in csv. Empty lines
+    // are skipped. Throws ParsingError subclass at the first malformed line.
+    // Commas, quotes and newlines of the whole block are located first,
+    // 64 bytes at a time, and lines are split into fields at the found
+    // offsets. Lines that do not split cleanly are parsed by VendorView,
+    // which reports the error.
+    explicit VendorBlock(const std::string_view csv);
+};
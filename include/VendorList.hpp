@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Registry.hpp"
+#include "Vendor.hpp"
+#include "utils.hpp"
+
+// Compact container of vendor records. Vendor names are interned in a string
+// pool shared by every record, so that hundreds of blocks owned by the same
+// vendor hold a 32-bit id instead of a copy of the name. Update dates are
+// packed into 32 bits. Elements are materialized as Vendor structs on access.
+class VendorList {
+public:
+    // Compact representation of a single record.
+    struct Row {
+        int64_t  mac_prefix;
+        uint32_t name;        // Id of the vendor name in the string pool
+        uint32_t last_update; // Date packed with pack_date
+        uint8_t  prefix_len;
+        bool     is_private;
+        Registry block_type;
+
+        // Returns the cache key of the record, as created by make_key.
+        constexpr int64_t key() const noexcept {
+            return make_key(mac_prefix, prefix_len);
+        }
+    };
+
+    // Forward iterator that materializes Vendor structs.
+    class Iterator {
+        const VendorList* list = nullptr;
+        size_t            pos  = 0;
+
+    public:
+        using iterator_concept  = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = Vendor;
+        using difference_type   = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        Iterator(const VendorList* list, const size_t pos) noexcept : list{list}, pos{pos} {}
+
+        Vendor operator*() const {
+            return (*list)[pos];
+        }
+
+        Iterator& operator++() noexcept {
+            pos++;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator tmp = *this;
+            pos++;
+            return tmp;
+        }
+
+        bool operator==(const Iterator& other) const noexcept = default;
+    };
+
+    // Set in a packed date if it holds the string pool id of a date
+    // that does not follow the YYYY/MM/DD format.
+    static constexpr uint32_t RAW_DATE = 1u << 31;
+
+private:
+    // Records in insertion order.
+    std::vector<Row> rows;
+
+    // Interned strings. Deque keeps the references held by ids stable.
+    std::deque<std::string> strings;
+
+    // Maps interned strings to their positions in strings.
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    // Returns the id of str, adding it to the pool if necessary.
+    uint32_t intern(const std::string_view str);
+
+    // Packs YYYY/MM/DD date into year << 9 | month << 5 | day. Empty string
+    // is packed as 0. Dates in other formats are interned and their ids
+    // are tagged with RAW_DATE, so that every value can be restored verbatim.
+    uint32_t pack_date(const std::string_view date);
+
+public:
+    VendorList() = default;
+
+    // Copies records and rebuilds the string pool index, since ids
+    // refers to the strings owned by the list.
+    VendorList(const VendorList& other);
+    VendorList& operator=(const VendorList& other);
+
+    VendorList(VendorList&&) noexcept            = default;
+    VendorList& operator=(VendorList&&) noexcept = default;
+
+    // Appends a record.
+    void emplace_back(
+        const int64_t          mac_prefix,
+        const uint8_t          prefix_len,
+        const std::string_view vendor_name,
+        const bool             is_private,
+        const Registry         block_type,
+        const std::string_view last_update
+    );
+
+    // Appends a copy of the record at position i of other.
+    void emplace_back(const VendorList& other, const size_t i);
+
+    // Appends a copy of v.
+    void push_back(const Vendor& v);
+
+    // Reserves space for n records.
+    void reserve(const size_t n);
+
+    // Returns the compact form of the record at position i.
+    const Row& row(const size_t i) const noexcept;
+
+    // Returns the update date of the compact record r.
+    std::string date_of(const Row& r) const;
+
+    // Returns the vendor name of the compact record r.
+    std::string_view name_of(const Row& r) const noexcept;
+
+    // Returns the number of distinct strings in the pool.
+    size_t pool_size() const noexcept;
+
+    // Returns the number of records.
+    size_t size() const noexcept;
+
+    // Sorts records by cache key (see make_key).
+    void sort();
+
+    // Sorts records by cache key and removes records with duplicate keys,
+    // keeping the first one of each. The result is ordered and de-duplicated
+    // like std::set<Vendor>.
+    void sort_unique();
+
+    Iterator begin() const noexcept;
+    Iterator end() const noexcept;
+
+    // Materializes the record at position i.
+    Vendor operator[](const size_t i) const;
+
+    // Compares materialized records.
+    bool operator==(const VendorList& other) const;
+};
@@ -8,13 +8,13 @@
 
 // Base class wrapping SQLite3 database connection.
 class Conn {
-    // Default busy timeout value for the connection.
-    static constexpr int BUSY_TIMEOUT_MS = 5000;
-
     // Signals whether sqlite3_initialize() function has been called.
     static std::once_flag sqlite_initialized;
 
 protected:
+    // Default busy timeout value for the connection.
+    static constexpr int BUSY_TIMEOUT_MS = 5000;
+
     // Pointer to the sqlite3 object.
     sqlite3* conn;
 
@@ -1,14 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <mutex>
-#include <set>
+#include <optional>
 #include <span>
 #include <string>
 #include <vector>
 
 #include "Conn.hpp"
 #include "Vendor.hpp"
+#include "VendorList.hpp"
 
 // Wrapper for read-only database connection.
 class ConnR : public Conn {
@@ -26,6 +28,20 @@ class ConnR : public Conn {
     // in the vendors table.
     int64_t count_records() const;
 
+    // Trigram index of the names table used by find_fuzzy, along with
+    // the data version of the database it was built from. Defined
+    // in the source file.
+    struct FuzzyNames;
+
+    // Index built by the first call of find_fuzzy. Rebuilt only if another
+    // connection modifies the database.
+    mutable std::shared_ptr<const FuzzyNames> fuzzy_names;
+    mutable std::mutex                        fuzzy_mutex;
+
+    // Returns the index of the names table, building it if it is missing
+    // or outdated.
+    std::shared_ptr<const FuzzyNames> fuzzy_index() const;
+
 public:
     // Constructs new read-only database connection given the database path.
     // If override_once_flags is set to true, the constructor ignores static
@@ -39,12 +55,63 @@ public:
 
     ~ConnR();
 
-    // Returns a vector containing every record in the database.
-    std::vector<Vendor> export_records() const;
+    // Returns every record in the database.
+    VendorList export_records() const;
+
+    // Searches for records using given MAC addresses. Results are sorted
+    // by prefix and contain no duplicates.
+    VendorList find_by_addr(std::span<const std::string> addresses) const;
+
+    // Searches for records using given MAC addresses. Unlike find_by_addr,
+    // which steps a statement once per address, all candidate prefixes are
+    // deduplicated, sorted and resolved by a single statement. Intended
+    // for large numbers of addresses.
+    VendorList find_by_addr_batch(std::span<const std::string> addresses) const;
+
+    // Searches for the most specific block (MA-S over MA-M over MA-L)
+    // of every given MAC address. Returns a vector parallel to addresses,
+    // holding either the found record or std::nullopt. A single descending
+    // range probe resolves most addresses. Point probes of the remaining
+    // candidates, from the longest to the shortest, follow only if the probe
+    // lands on a block that does not cover the address.
+    std::vector<std::optional<Vendor>> find_best_by_addr(std::span<const std::string> addresses) const;
+
+    // Searches for records with given vendor names. Results are sorted
+    // by prefix and contain no duplicates. Terms are matched against
+    // the distinct names of the names table, the matching ones are joined
+    // to their records. Terms with a run of 3 literal characters are looked
+    // up in the trigram index, the others and long lists of names are
+    // scanned in memory (see NameScanner).
+    VendorList find_by_name(std::span<const std::string> names) const;
+
+    // Searches for records with given vendor names like find_by_name,
+    // grouped by the name they match. The list at position i holds
+    // the records matching names[i], sorted by prefix. A record matching
+    // several names is listed for each of them. Long lists of names are
+    // tagged with term ids in the same single pass (see NameMatcher::match).
+    std::vector<VendorList> find_by_name_grouped(std::span<const std::string> names) const;
+
+    // Searches for records with vendor names equal to given ones after
+    // normalization (see normalize_name), e.g. "cisco systems" finds
+    // "Cisco Systems, Inc". Results are sorted by prefix and contain
+    // no duplicates. Every name is resolved by a single index seek.
+    VendorList find_exact(std::span<const std::string> names) const;
+
+    // Searches for records with vendor names similar to given ones, e.g.
+    // misspelled. For every name, the records of at most top closest
+    // vendor names are returned, from the best match (see FuzzyIndex).
+    // Records found for an earlier name are not repeated. The trigram index
+    // is stored in the snapshot. Here it is built from the names table
+    // on the first call and kept until the database changes.
+    VendorList find_fuzzy(std::span<const std::string> names, const size_t top) const;
 
-    // Searches for records using given MAC addresses.
-    std::set<Vendor> find_by_addr(std::span<const std::string> addresses) const;
+    // Searches for records with normalized vendor names starting with given
+    // ones, normalized (see normalize_name). Results are sorted by prefix
+    // and contain no duplicates. Every name is resolved by a range scan
+    // of the index.
+    VendorList find_prefix(std::span<const std::string> names) const;
 
-    // Searches for records with given vendor names.
-    std::set<Vendor> find_by_name(std::span<const std::string> names) const;
+    // Returns the value stored under key in the meta table, or std::nullopt
+    // if there is none. Throws CacheError if a SQLite error is encountered.
+    std::optional<std::string> get_meta(const std::string& key) const;
 };
@@ -1,27 +1,157 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <optional>
 #include <source_location>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Conn.hpp"
+#include "Stmt.hpp"
+#include "Vendor.hpp"
 
 // Wrapper for read-write database connection.
 class ConnRW : public Conn {
+    // Dictionary of distinct vendor names. Every name is stored once,
+    // along with its normalized form (see normalize_name) that serves
+    // exact and starts-with name searches.
+    static constexpr const char* CREATE_NAMES_STMT =
+        "CREATE TABLE names ("
+        "id   INTEGER PRIMARY KEY,"
+        "name TEXT NOT NULL UNIQUE,"
+        "norm TEXT"
+        ")";
+
+    static constexpr const char* CREATE_NORM_INDEX_STMT =
+        "CREATE INDEX names_norm ON names (norm)";
+
+    // Records without a vendor name have NULL name_id. Column hash holds
+    // VendorView::hash of the record as received from the data source,
+    // before customize_db modifies it.
     static constexpr const char* CREATE_TABLE_STMT =
         "CREATE TABLE vendors ("
         "prefix  INTEGER PRIMARY KEY,"
-        "name    TEXT,"
+        "name_id INTEGER REFERENCES names (id),"
         "private BOOLEAN NOT NULL,"
         "block   INTEGER,"
-        "updated TEXT"
+        "updated TEXT,"
+        "hash    INTEGER"
+        ")";
+
+    // Joins the names found by a name search to their records.
+    static constexpr const char* CREATE_NAME_ID_INDEX_STMT =
+        "CREATE INDEX vendors_name_id ON vendors (name_id)";
+
+    // Records with their vendor names, in the column order expected
+    // by Stmt::get_row. Read by every search.
+    static constexpr const char* CREATE_VIEW_STMT =
+        "CREATE VIEW vendor_rows AS "
+        "SELECT vendors.prefix, names.name, vendors.private, vendors.block, vendors.updated, vendors.name_id "
+        "FROM vendors LEFT JOIN names ON names.id = vendors.name_id";
+
+    // Trigram index of vendor names. Rows are stored in table names
+    // and indexed on demand with REBUILD_INDEX_STMT.
+    static constexpr const char* CREATE_INDEX_STMT =
+        "CREATE VIRTUAL TABLE names_fts USING fts5("
+        "name,"
+        "content='names',"
+        "content_rowid='id',"
+        "tokenize='trigram'"
         ")";
 
+    // Properties of the cache, stored as text under their keys, e.g.
+    // the validators of the downloaded update (see Downloader::Validators).
+    static constexpr const char* CREATE_META_STMT =
+        "CREATE TABLE meta ("
+        "key   TEXT PRIMARY KEY,"
+        "value TEXT NOT NULL"
+        ") WITHOUT ROWID";
+
+    static constexpr const char* REBUILD_INDEX_STMT =
+        "INSERT INTO names_fts(names_fts) VALUES('rebuild')";
+
+    // Adds vendor name ?1 to the dictionary, unless it is already present.
+    // NULL names are ignored. Normalized names are computed
+    // by the normalize_name SQL function, registered on every connection.
+    static constexpr const char* INSERT_NAME_STMT =
+        "INSERT OR IGNORE INTO names "
+        "(name, norm) "
+        "VALUES (?1, normalize_name(?1))";
+
+    // Expects the vendor name to be present in the dictionary. The hash
+    // is computed by the row_hash SQL function, registered on every
+    // connection.
     static constexpr const char* INSERT_STMT =
         "INSERT INTO vendors "
-        "(prefix, name, private, block, updated) "
-        "VALUES (?1, ?2, ?3, ?4, ?5)";
+        "(prefix, name_id, private, block, updated, hash) "
+        "VALUES (?1, (SELECT id FROM names WHERE name = ?2), ?3, ?4, ?5, row_hash(?2, ?3, ?4, ?5))";
+
+    // Same as INSERT_STMT, but replaces the fields of an existing record.
+    static constexpr const char* UPDATE_STMT =
+        "UPDATE vendors "
+        "SET name_id = (SELECT id FROM names WHERE name = ?2), private = ?3, block = ?4, updated = ?5, hash = row_hash(?2, ?3, ?4, ?5) "
+        "WHERE prefix = ?1";
+
+    // Row of INSERT_NAME_STMT and INSERT_STMT, with parameters numbered
+    // from ?1 and ?2 respectively. Repeated by multi-row statements.
+    static constexpr std::string_view INSERT_NAME_ROW = "(?1, normalize_name(?1))";
+    static constexpr std::string_view INSERT_ROW      = "(?1, (SELECT id FROM names WHERE name = ?2), ?3, ?4, ?5, row_hash(?2, ?3, ?4, ?5))";
+
+    // Keep the name index in step with the names table while merge
+    // modifies it. Created as temporary triggers for the duration
+    // of the merge, as the index is otherwise rebuilt on demand.
+    static constexpr const char* CREATE_INDEX_INSERT_TRIGGER =
+        "CREATE TEMP TRIGGER names_fts_insert AFTER INSERT ON names BEGIN "
+        "INSERT INTO names_fts (rowid, name) VALUES (new.id, new.name); "
+        "END";
+
+    static constexpr const char* CREATE_INDEX_DELETE_TRIGGER =
+        "CREATE TEMP TRIGGER names_fts_delete AFTER DELETE ON names BEGIN "
+        "INSERT INTO names_fts (names_fts, rowid, name) VALUES ('delete', old.id, old.name); "
+        "END";
+
+    // Removes the names left without records by an update.
+    static constexpr const char* DELETE_UNUSED_NAMES_STMT =
+        "DELETE FROM names WHERE id NOT IN "
+        "(SELECT name_id FROM vendors WHERE name_id IS NOT NULL)";
+
+    // Inserts records, and their vendor names into the dictionary, width
+    // records per statement. Records are buffered until width of them
+    // are added or flush is called, so the data they view must remain
+    // valid until then.
+    class RowWriter {
+        ConnRW& conn;
+
+        // Buffered records.
+        std::vector<VendorView> rows;
+
+        // Statements inserting a single name and record.
+        Stmt name_stmt;
+        Stmt stmt;
+
+        // Statements inserting width names and records. Present
+        // if width is greater than 1.
+        std::optional<Stmt> names_stmt;
+        std::optional<Stmt> rows_stmt;
+
+        const size_t width;
+
+    public:
+        RowWriter(ConnRW& conn, const size_t width);
+
+        // Buffers v, inserting the buffered records if width of them
+        // are present. Throws CacheError if a SQLite error is encountered.
+        void add(const VendorView& v);
+
+        // Inserts the buffered records. Throws CacheError if a SQLite error
+        // is encountered.
+        void flush();
+    };
 
     // Signals whether prepare_database has been called.
     static std::once_flag db_prepared;
@@ -32,28 +162,82 @@ class ConnRW : public Conn {
     // Signals whether database transaction is opened.
     bool transaction_open;
 
-    // Creates table vendors in the database. Throws CacheError if a SQLite
-    // error is encountered.
+    // Number of records inserted by a single statement. Greater than 1
+    // in bulk-load mode.
+    size_t insert_width;
+
+    // Values of the pragmas changed by begin_bulk_load, as they were before
+    // it, restored by end_bulk_load.
+    std::array<std::string, 4> saved_pragmas;
+
+    // Creates tables names, vendors and meta, the indexes and view vendor_rows
+    // in the database. Throws CacheError if a SQLite error is encountered.
     void create_table();
 
     // Performs database modifications on update. Inserts custom entries
     // and modifies a few existing ones. Data is hard-coded for simplicity.
+    // Modifications that are already present are skipped, so that
+    // the function can be called again after merge.
     // Parameter err is used to redirect warnings for testing.
     // Throws if a SQLite error is encountered.
     void customize_db(std::ostream& err);
 
-    // Drops table vendors. Throws CacheError if a SQLite error is encountered.
+    // Drops the objects created by create_table, as well as the ones left
+    // by earlier cache versions. Throws CacheError if a SQLite error
+    // is encountered.
     void drop_table();
 
     // Constructs a statement from string literal and executes it.
     // Throws CacheError if rc is not SQLITE_OK or SQLITE_DONE.
     void exec(std::string_view stmt_str, std::source_location loc = std::source_location::current());
 
+    // Completes an update started by insert. Calls customize_db if update
+    // is true, removes unused names, rebuilds the name index and commits
+    // the transaction.
+    void finish_insert(const bool update, std::ostream& err);
+
+    // Adds the vendor name of v to the dictionary with name_stmt (prepared
+    // from INSERT_NAME_STMT) and inserts v with stmt (prepared
+    // from INSERT_STMT). Throws CacheError if a SQLite error is encountered.
+    void insert_vendor(Stmt& name_stmt, Stmt& stmt, const VendorView& v);
+
     // Handles the initial preparation stage. Ensures the database exists
     // and has been correctly formatted.
     void prepare_db();
 
+    // Registers normalize_name as a deterministic SQL function of one
+    // argument. NULL and names without letters or digits are normalized
+    // to NULL. Registers row_hash(name, private, block, updated), which
+    // returns VendorView::hash of a record bound as by Stmt::bind_row.
+    // Throws CacheError if a SQLite error is encountered.
+    void register_functions();
+
+    // Assigns name to the record with cache key. Returns the number
+    // of records changed. Throws CacheError if a SQLite error
+    // is encountered.
+    int set_name(const int64_t key, const std::string& name);
+
 public:
+    // Numbers of records changed by merge.
+    struct Changes {
+        size_t added;
+        size_t changed;
+        size_t removed;
+    };
+
+    // Number of records inserted by a single statement in bulk-load mode,
+    // unless specified otherwise.
+    static constexpr size_t BULK_WIDTH = 16;
+
+    // Largest number of records inserted by a single statement. The time
+    // SQLite takes to prepare a multi-row statement grows quadratically
+    // with its width.
+    static constexpr size_t MAX_BULK_WIDTH = 256;
+
+    // Largest share of the current records that merge may remove. A source
+    // that would remove more is more likely truncated than genuine.
+    static constexpr double MAX_REMOVED_SHARE = 0.5;
+
     // Constructs new read-write database connection given the database path.
     // If the file is not present, it is created.
     // If override_once_flags is set to true, the constructor ignores static
@@ -72,27 +256,105 @@ public:
     // is encountered.
     void begin();
 
-    // Deletes all records from the vendors table. Throws CacheError
-    // if a SQLite error is encountered.
+    // Switches the connection to bulk-load mode, meant for filling a new
+    // cache that is discarded on failure (see rebuild). Records are inserted
+    // width at a time, by multi-row statements. Width is limited
+    // to MAX_BULK_WIDTH and the number of parameters allowed by SQLite.
+    // The rollback journal is kept
+    // in memory, writes are not synced to disk, the page cache is enlarged
+    // and the database is locked exclusively, so a crash during the load
+    // may leave the database corrupted. Must not be called inside
+    // a transaction. Throws CacheError if a SQLite error is encountered.
+    void begin_bulk_load(const size_t width = BULK_WIDTH);
+
+    // Deletes all records and vendor names, along with the name index.
+    // Throws CacheError if a SQLite error is encountered.
     void clear_table();
 
     // Commits database transaction. Throws CacheError if a SQLite error
     // is encountered.
     void commit();
 
+    // Restores the settings changed by begin_bulk_load to their values
+    // before the load and releases the exclusive lock. Must not be called
+    // inside a transaction. Throws CacheError if a SQLite error
+    // is encountered.
+    void end_bulk_load();
+
     // Opens a new transaction, parses CSV lines contained in is and
     // inserts them into the database. The function expects the first line
-    // to be the header line - it is discarded. If no exception is thrown,
-    // the transaction is committed.
+    // to be the header line - it is discarded. Lines are read and parsed
+    // on a separate thread, in batches, while the previous batches are
+    // inserted. If no exception is thrown, the transaction is committed.
+    // Exceptions thrown while reading or parsing is are rethrown
+    // on the calling thread.
     // If update is true, the function deletes all records from the vendors
     // table before inserting new ones and calls the customize_db member
     // function after all the records from is are transfered to the database.
+    // Names no longer used by any record are removed and the name index
+    // is rebuilt before the transaction is committed.
     // Optional parameter err is used to redirect warnings for testing.
     void insert(std::istream& is, const bool update, std::ostream& err = std::cerr);
 
+    // Same as insert(std::istream&, ...), but parses CSV lines contained
+    // in csv in place. Fields are bound to SQLite statements without being
+    // copied. csv is split into blocks of whole lines, parsed concurrently,
+    // by default one per hardware thread. If a line is malformed, its
+    // ParsingError is thrown before any record is inserted. Records are
+    // inserted in ascending key order, which keeps appends to the vendors
+    // table sequential.
+    void insert(const std::string_view csv, const bool update, std::ostream& err = std::cerr, size_t threads = 0);
+
+    // Updates the records to match CSV lines contained in is, read
+    // and parsed on a separate thread as by insert(std::istream&, ...).
+    // Records are compared by key and hash (see VendorView::hash) as they
+    // arrive, and only the added, changed and removed ones are written,
+    // in a single transaction. The name index is updated along with
+    // the names, and customize_db is applied to the result. Records inserted
+    // by customize_db are kept. Returns the numbers of records added, changed
+    // and removed. Throws ParsingError if a line is malformed and CacheError
+    // if a SQLite error is encountered. Throws UpdateError if is holds
+    // no records or would remove more than MAX_REMOVED_SHARE of them.
+    // On failure, the transaction is rolled back. Meant to be called
+    // on a copy of the cache made by rebuild, so that readers never
+    // wait for it.
+    // Optional parameter err is used to redirect warnings for testing.
+    Changes merge(std::istream& is, std::ostream& err = std::cerr);
+
+    // Builds a new cache in a temporary file next to the database at path
+    // and renames it over the database once it is complete. The new cache
+    // is filled by fill, which receives a connection to it in bulk-load
+    // mode. If from_current is true, the new cache starts as a copy
+    // of the database, e.g. for merge, and the write lock of the database
+    // is taken before the copy, so that no other writer changes it until
+    // the swap. Before the swap, the new cache must hold a record
+    // of the source, besides the one inserted by customize_db, and pass
+    // the checks of ConnR. Connections opened to the old database keep
+    // reading it, without waiting for the update to finish. If fill throws
+    // or the checks fail, the temporary file is removed and the database
+    // is left unchanged. Returns the number of records in the new cache,
+    // besides the one inserted by customize_db.
+    //
+    // The write lock of the old database is taken for the swap, which waits
+    // for its writers and rolls back a journal left by a crashed one.
+    // A connection that keeps writing to the old database after the swap
+    // may still leave a journal next to the new one, so writers must not
+    // outlive an update. Where an open database cannot be renamed over
+    // (Windows), the new cache is copied into it with the SQLite backup API,
+    // and readers wait for the copy instead.
+    //
+    // Throws UpdateError if the source holds no records and CacheError
+    // if the database cannot be copied or replaced.
+    static size_t rebuild(const std::string& path, const std::function<void(ConnRW&)>& fill, const bool from_current = false);
+
     // Reverts uncommitted database transaction. Returns SQLite result code.
     int rollback() noexcept;
 
+    // Stores value under key in the meta table, replacing the previous one.
+    // If value is std::nullopt, the key is removed. Throws CacheError
+    // if a SQLite error is encountered.
+    void set_meta(const std::string& key, const std::optional<std::string>& value);
+
     // Assigns the user_version value as specifed. Commits database transaction.
     // Throws CacheError if a SQLite error is encountered.
     void set_version(const int version);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ConnR.hpp"
+#include "NameScanner.hpp"
+#include "Vendor.hpp"
+#include "VendorList.hpp"
+
+// In-memory lookup engine for MAC address and vendor name searches.
+// The vendors table is loaded once and lookups are resolved without any
+// SQLite calls. Intended for long-running processes that perform a large
+// number of searches.
+class Index {
+    // Sorted search keys of a single block length stored in Eytzinger
+    // (breadth-first) layout, together with a parallel array of row ids.
+    // Element 0 of both arrays is unused to simplify the search arithmetic.
+    struct Bucket {
+        std::vector<int64_t>  keys;
+        std::vector<uint32_t> rows;
+
+        // Returns a pointer to the row id matching key or nullptr
+        // if key is not present in the bucket.
+        const uint32_t* find(const int64_t key) const noexcept;
+    };
+
+    // Keys are split by the length tag assigned by make_key, so that
+    // every tree holds blocks of a single length and stays small.
+    std::array<Bucket, MAC_NIBBLES + 1> buckets;
+
+    // Records referenced by row ids stored in buckets.
+    VendorList records;
+
+    // Vendor names of records. Positions of names are row ids.
+    NameScanner names;
+
+    // Returns the position of the bucket that holds key.
+    static size_t bucket_of(const int64_t key) noexcept;
+
+    // Returns the vendor names of records, in row order.
+    static std::vector<std::string_view> names_of(const VendorList& records);
+
+public:
+    // Builds the index from every record present in the database. Name
+    // searches are split across threads, by default one per hardware thread.
+    explicit Index(const ConnR& conn, size_t threads = 0);
+
+    // Searches for records using given MAC addresses. Returns the same
+    // results as ConnR::find_by_addr.
+    VendorList find_by_addr(std::span<const std::string> addresses) const;
+
+    // Searches for records with given vendor names. Returns the same
+    // results as ConnR::find_by_name. Names are scanned in memory
+    // (see NameScanner).
+    VendorList find_by_name(std::span<const std::string> names) const;
+
+    // Returns the number of indexed records.
+    size_t size() const noexcept;
+};
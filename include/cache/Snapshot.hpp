@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "FuzzyIndex.hpp"
+#include "Vendor.hpp"
+#include "VendorList.hpp"
+
+// Read-only, memory-mapped copy of the vendors table. It is written next to
+// the database after every update and lets short-lived processes answer
+// queries without opening SQLite. The mapping is shared through the page
+// cache by every process on the host.
+//
+// File layout:
+//   - Header
+//   - int64_t keys[count], encoded with make_key, sorted ascending
+//   - Record   records[count], parallel to keys
+//   - uint64_t oui_bits[OUI_WORDS], presence bitmap of OUIs with an MA-L sized record
+//   - uint32_t oui_ranks[OUI_WORDS], number of bits set before each word of oui_bits
+//   - uint32_t oui_rows[oui_count], positions of MA-L sized records, by OUI rank
+//   - uint32_t refined[refined_count], OUIs containing longer blocks, sorted ascending
+//   - FuzzyIndex::Name fuzzy_names[name_count], distinct non-empty vendor names
+//   - uint32_t name_ranges[name_count + 1], ranges of name_rows, by name
+//   - uint32_t name_rows[named_count], positions of records, grouped by name
+//   - uint32_t gram_keys[gram_count], trigrams of the names, sorted ascending
+//   - uint32_t gram_offs[gram_count + 1], ranges of gram_postings, by trigram
+//   - uint32_t gram_postings[posting_count], names containing each trigram
+//   - NormName norm_names[norm_count], normalized names, sorted ascending
+//   - char     strings[strings_size], vendor names, normalized names and update dates
+//
+// The bitmap and its rank directory resolve an OUI to its record with two
+// memory accesses, without searching keys. Only the small number of OUIs
+// listed in refined, divided into MA-M and MA-S blocks, fall back to binary
+// search. The trigram index of the names serves approximate name searches
+// (see FuzzyIndex). Exact and starts-with name searches are resolved
+// by binary search of the normalized names.
+class Snapshot {
+public:
+    // Incremented on every change to the file layout.
+    static constexpr uint32_t FORMAT_VERSION = 6;
+
+private:
+    // Identifies the file type.
+    static constexpr char MAGIC[8] = {'M', 'A', 'C', 'P', 'P', 'S', 'N', 'P'};
+
+    // Number of 64-bit words in the OUI presence bitmap.
+    static constexpr size_t OUI_WORDS = (size_t{1} << 24) / 64;
+
+    struct Header {
+        char     magic[8];
+        uint32_t format_version;
+        uint32_t cache_version;
+        // State of the database the snapshot was generated from.
+        // Used to detect a snapshot outdated by another writer.
+        int64_t  db_size;
+        int64_t  db_mtime;
+        uint32_t db_changes;
+        uint32_t padding;
+        uint64_t count;
+        uint64_t oui_count;
+        uint64_t refined_count;
+        uint64_t name_count;
+        uint64_t named_count;
+        uint64_t gram_count;
+        uint64_t posting_count;
+        uint64_t norm_count;
+        uint64_t strings_size;
+    };
+
+    // Fixed-width record. Offsets point into the strings blob.
+    struct Record {
+        uint32_t name_off;
+        uint32_t name_len;
+        uint32_t updated_off;
+        uint8_t  updated_len;
+        uint8_t  is_private;
+        uint8_t  block_type;
+        uint8_t  padding;
+    };
+
+    // Vendor name normalized with normalize_name, stored at off
+    // in the strings blob. Refers to the name at its position
+    // in fuzzy_names.
+    struct NormName {
+        uint32_t off;
+        uint32_t len;
+        uint32_t name;
+    };
+
+    // Base address of the mapping.
+    const std::byte* data;
+
+    // Size of the mapping in bytes.
+    size_t size;
+
+#if defined(_WIN32)
+    // File mapping object handle.
+    void* mapping;
+#endif
+
+    // Views into the mapped sections.
+    std::span<const int64_t>  keys;
+    std::span<const Record>   records;
+    std::span<const uint64_t> oui_bits;
+    std::span<const uint32_t> oui_ranks;
+    std::span<const uint32_t> oui_rows;
+    std::span<const uint32_t> refined;
+    std::string_view          strings;
+
+    std::span<const FuzzyIndex::Name> fuzzy_names;
+    std::span<const uint32_t>         name_ranges;
+    std::span<const uint32_t>         name_rows;
+    std::span<const uint32_t>         gram_keys;
+    std::span<const uint32_t>         gram_offs;
+    std::span<const uint32_t>         gram_postings;
+    std::span<const NormName>         norm_names;
+
+    // Identifies a state of the database file. The file change counter
+    // stored in the SQLite header is incremented by every committed
+    // transaction, so it tells apart writes that leave the size unchanged
+    // and happen within the resolution of the modification time.
+    struct DbStamp {
+        int64_t  size;
+        int64_t  mtime;
+        uint32_t changes;
+
+        bool operator==(const DbStamp&) const = default;
+    };
+
+    // Returns the size, modification time and file change counter
+    // of the database at db_path.
+    static DbStamp stamp_db(const std::string& db_path);
+
+    // Reconstructs Vendor stored at position i.
+    Vendor get_row(const size_t i) const;
+
+    // Appends the record stored at position i to list.
+    void get_row(const size_t i, VendorList& list) const;
+
+    // Returns the position of the record with given cache key. MA-L sized
+    // keys are resolved through the OUI bitmap, longer ones are searched
+    // for only if their OUI is refined. Throws CacheError if the OUI
+    // index points outside of the snapshot.
+    std::optional<size_t> find_key(const int64_t key) const;
+
+    // Returns a view of len bytes at off in the strings blob. Throws
+    // CacheError if the range exceeds the blob.
+    std::string_view get_string(const uint32_t off, const uint32_t len) const;
+
+    // Returns the positions of the records with the name at position name
+    // in fuzzy_names. Throws CacheError if they exceed the snapshot.
+    std::span<const uint32_t> rows_of(const uint32_t name) const;
+
+public:
+    // Maps the snapshot at path into memory. Throws CacheError if the file
+    // cannot be mapped, its format or cache version does not match the ones
+    // expected by the application, or it does not describe the current
+    // state of the database at db_path.
+    Snapshot(const std::string& path, const std::string& db_path);
+
+    Snapshot(const Snapshot&)            = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Unmaps the file.
+    ~Snapshot();
+
+    // Returns every record in the snapshot.
+    VendorList export_records() const;
+
+    // Searches for records using given MAC addresses. Returns the same results
+    // as ConnR::find_by_addr.
+    VendorList find_by_addr(std::span<const std::string> addresses) const;
+
+    // Searches for the most specific block of every given MAC address.
+    // Returns the same results as ConnR::find_best_by_addr.
+    std::vector<std::optional<Vendor>> find_best_by_addr(std::span<const std::string> addresses) const;
+
+    // Searches for records with given vendor names. Returns the same results
+    // as ConnR::find_by_name.
+    VendorList find_by_name(std::span<const std::string> names) const;
+
+    // Searches for records with given vendor names, grouped by the name
+    // they match. Returns the same results as ConnR::find_by_name_grouped.
+    std::vector<VendorList> find_by_name_grouped(std::span<const std::string> names) const;
+
+    // Searches for records with vendor names equal to given ones after
+    // normalization. Returns the same results as ConnR::find_exact.
+    VendorList find_exact(std::span<const std::string> names) const;
+
+    // Searches for records with vendor names similar to given ones.
+    // Returns the same results as ConnR::find_fuzzy, resolved through
+    // the trigram index without visiting other records.
+    VendorList find_fuzzy(std::span<const std::string> names, const size_t top) const;
+
+    // Searches for records with normalized vendor names starting with given
+    // ones. Returns the same results as ConnR::find_prefix.
+    VendorList find_prefix(std::span<const std::string> names) const;
+
+    // Returns the snapshot path that belongs to the database at db_path.
+    static std::string path_for(const std::string& db_path);
+
+    // Writes records into a snapshot file at path, describing the database
+    // at db_path. The file is written under a temporary name and renamed
+    // afterwards, so that readers never observe a partially written snapshot.
+    // Every distinct vendor name and update date is stored only once.
+    // Throws CacheError on failure.
+    static void write(const std::string& path, const std::string& db_path, VendorList records);
+};
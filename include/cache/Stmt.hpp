@@ -4,9 +4,11 @@
 #include <source_location>
 #include <sqlite3.h>
 #include <string>
+#include <string_view>
 
 #include "Registry.hpp"
 #include "Vendor.hpp"
+#include "VendorList.hpp"
 
 // A RAII wrapper for sqlite3_stmt object.
 class Stmt {
@@ -34,10 +36,10 @@ public:
     // Throws CacheError if SQLite error is encountered.
     void bind(const int coln, const Registry value, const std::source_location loc = std::source_location::current());
 
-    // Binds a string to coln of the statement. Returns SQLite result code.
-    // Empty string is bound as NULL.
-    // Throws CacheError if SQLite error is encountered.
-    void bind(const int coln, const std::string& value, const std::source_location loc = std::source_location::current());
+    // Binds a string to coln of the statement. Empty string is bound as NULL.
+    // The string is not copied, so it must remain valid until the statement
+    // is stepped. Throws CacheError if SQLite error is encountered.
+    void bind(const int coln, const std::string_view value, const std::source_location loc = std::source_location::current());
 
     // Clears parameters that were bound to the statement. Throws CacheError
     // if SQLite error is encountered.
@@ -49,17 +51,21 @@ public:
     // Generic function for extracting value from SQLite table column.
     // Supported types:
     //   - std::string
+    //   - std::string_view
     //   - bool
     //   - int32
     //   - int64
     //   - Registry enum class
     //
     // For strings, if a column value is NULL, an empty string is returned.
+    // A std::string_view remains valid until the statement is stepped
+    // or reset.
     // For Registry values, encountering NULL or a value outside of the defined
     // enum class range causes Registry::Unknown to be returned.
     template <typename T>
         requires(
             std::same_as<T, std::string> ||
+            std::same_as<T, std::string_view> ||
             std::same_as<T, Registry> ||
             std::same_as<T, bool> ||
             std::same_as<T, int32_t> ||
@@ -74,6 +80,14 @@ public:
             return std::string{reinterpret_cast<const char*>(text)};
         }
 
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            if (sqlite3_column_type(stmt, coln) == SQLITE_NULL) {
+                return "";
+            }
+            const unsigned char* text = sqlite3_column_text(stmt, coln);
+            return std::string_view{reinterpret_cast<const char*>(text), static_cast<size_t>(sqlite3_column_bytes(stmt, coln))};
+        }
+
         if constexpr (std::is_same_v<T, Registry>) {
             if (sqlite3_column_type(stmt, coln) == SQLITE_NULL) {
                 return Registry::Unknown;
@@ -102,9 +116,17 @@ public:
     // Retrieves Vendor instance from SQLite row.
     Vendor get_row() noexcept;
 
-    // Binds Vendor instance to the statement. Throws CacheError if any SQLite
-    // operation fails.
-    void insert_row(const Vendor& v);
+    // Appends SQLite row to list without materializing a Vendor instance.
+    void get_row(VendorList& list);
+
+    // Binds the fields of a vendor record to five consecutive parameters
+    // of the statement, starting at coln. Throws CacheError if SQLite error
+    // is encountered.
+    void bind_row(const int coln, const VendorView& v);
+
+    // Binds the fields of a vendor record to the statement and steps it.
+    // Throws CacheError if any SQLite operation fails.
+    void insert_row(const VendorView& v);
 
     // Resets the statement. Throws CacheError if SQLite error is encountered.
     void reset(const std::source_location loc = std::source_location::current());
@@ -80,6 +80,13 @@ public:
         : ParsingError{"no comma found in CSV line", line} {}
 };
 
+// Thrown if prefix field contains more hex digits than a MAC address.
+class PrefixLengthError : public ParsingError {
+public:
+    explicit PrefixLengthError(const std::string& line)
+        : ParsingError{"prefix field is longer than a MAC address", line} {}
+};
+
 // Thrown if prefix field ends the line.
 class PrefixTermError : public ParsingError {
 public:
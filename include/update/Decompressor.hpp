@@ -0,0 +1,94 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "Reader.hpp"
+#include "Updater.hpp"
+
+// Class that provides data for cache update from a compressed local file.
+// The file is memory-mapped (see Reader) and decompressed by the wrapped
+// stream as it is read, so that the records are parsed without storing
+// the decompressed file.
+class Decompressor : public Updater {
+public:
+    // Compression formats, recognized by the magic number of the data.
+    enum class Format {
+        None,
+        Gzip,
+        Zstd,
+    };
+
+private:
+    // Size of the buffer holding decompressed data.
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+    // Decoder of a compression format, with one subclass per format.
+    // Defined in the source file.
+    class Codec;
+    class GzipCodec;
+    class ZstdCodec;
+
+    // Stream buffer that decompresses the mapped file chunk by chunk.
+    // Kept on the heap to give the stream a stable buffer address
+    // when Decompressor is moved.
+    struct Inflater : std::streambuf {
+        // Compressed file.
+        Reader reader;
+
+        std::unique_ptr<Codec> codec;
+
+        // Decompressed chunk exposed as the get area.
+        std::unique_ptr<char[]> chunk;
+
+        // Number of bytes decompressed so far.
+        size_t total;
+
+        std::istream stream;
+
+        // Throws UpdateError if the format of the data held by reader
+        // is not supported.
+        Inflater(Reader reader);
+
+        Inflater(const Inflater&)            = delete;
+        Inflater& operator=(const Inflater&) = delete;
+
+        ~Inflater();
+
+    protected:
+        // Throws UpdateError if the data is corrupted, truncated
+        // or decompresses to more than MAX_FSIZE bytes.
+        int_type underflow() override;
+    };
+
+    std::unique_ptr<Inflater> inflater;
+
+public:
+    // Constructs a new Decompressor instance that decompresses the file
+    // mapped by reader. Throws UpdateError if the file is not compressed
+    // in a supported format.
+    Decompressor(Reader reader);
+
+    Decompressor(const Decompressor&)            = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    Decompressor(Decompressor&& other)            = default;
+    Decompressor& operator=(Decompressor&& other) = default;
+
+    ~Decompressor() = default;
+
+    // Returns the compression format of data, or Format::None if it is
+    // not compressed in a recognized format.
+    static Format detect(const std::string_view data) noexcept;
+
+    // Returns a reference to a stream yielding the decompressed data.
+    // The stream rethrows errors raised by decompression.
+    std::istream& get() noexcept override final;
+
+    // Returns true if the application is built with support for format.
+    // Zstandard support is optional.
+    static bool supports(const Format format) noexcept;
+};
@@ -1,37 +1,143 @@
 #pragma once
 
 #include <curl/curl.h>
+#include <memory>
 #include <mutex>
-#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
 
+#include "Channel.hpp"
 #include "Updater.hpp"
 
 // Class that provides data for cache update from a remote source.
+// The transfer runs on a separate thread and the wrapped stream yields
+// the data as it arrives, so that it can be parsed and stored while
+// the download is still in progress. Compressed transfer is negotiated
+// with the server and decoded by libcurl. The request can be made
+// conditional on the validators of an earlier response, so that data
+// that has not changed since is not transferred again.
 class Downloader : public Updater {
+public:
+    // Validators of a response, i.e. the values of its ETag
+    // and Last-Modified headers. Empty if the header is absent.
+    struct Validators {
+        std::string etag;
+        std::string last_modified;
+    };
+
+    // Seconds allowed for connecting to the server.
+    static constexpr long CONNECT_TIMEOUT = 30;
+
+    // Lowest transfer speed, in bytes per second, tolerated for longer
+    // than the stall timeout.
+    static constexpr long LOW_SPEED_LIMIT = 1;
+
+    // Seconds for which the transfer may stay below LOW_SPEED_LIMIT,
+    // unless specified otherwise.
+    static constexpr long STALL_TIMEOUT = 30;
+
+private:
+    // Number of received chunks buffered ahead of the reader. Chunks hold
+    // at most CURL_MAX_WRITE_SIZE (16 KiB) bytes each.
+    static constexpr size_t QUEUED_CHUNKS = 64;
+
+    // Stream buffer that reads the chunks received by the transfer thread.
+    // If the transfer fails, underflow throws UpdateError once all
+    // the received data has been read.
+    class ChunkBuf : public std::streambuf {
+        Channel<std::string>& chunks;
+
+        // Result of the transfer, valid once chunks is closed.
+        const CURLcode& result;
+
+        // Chunk currently exposed as the get area.
+        std::string chunk;
+
+    protected:
+        int_type underflow() override;
+
+    public:
+        ChunkBuf(Channel<std::string>& chunks, const CURLcode& result)
+            : chunks{chunks}, result{result} {}
+    };
+
+    // State shared with the transfer thread. Kept on the heap to give it
+    // a stable address when Downloader is moved.
+    struct Transfer {
+        CURL* curl;
+
+        // Conditional request headers, sent if validators were given.
+        curl_slist* headers;
+
+        Channel<std::string> chunks;
+        CURLcode             result;
+
+        // Number of decoded bytes received. Limited to MAX_FSIZE.
+        size_t size;
+
+        // HTTP status code and validators of the response, valid once
+        // chunks is closed.
+        long       status;
+        Validators received;
+
+        ChunkBuf     buf;
+        std::istream stream;
+
+        std::thread thread;
+
+        Transfer(CURL* curl);
+
+        // Stops the transfer if it is still in progress and releases
+        // the CURL object and the request headers.
+        ~Transfer();
+    };
+
     // Signals whether curl_global_init() function has been called.
     static std::once_flag curl_init;
 
-    // CURL object.
-    CURL* curl;
+    std::unique_ptr<Transfer> transfer;
 
-    // Data retrieved from source.
-    std::stringstream data;
+    // HEADERFUNCTION function for CURL. Stores the validators
+    // of the response. Headers of earlier responses, e.g. redirects,
+    // are discarded.
+    static size_t read_header(char* buffer, size_t size, size_t nitems, void* userp);
 
     // WRITEFUNCTION function for CURL.
     static size_t write_data(void* buffer, size_t size, size_t nmemb, void* userp);
 
+    // XFERINFOFUNCTION function for CURL. Aborts the transfer once
+    // the reader is gone, even if no data arrives.
+    static int progress(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
 public:
-    // Constructs a new Downloader instance and downloads data from url.
-    Downloader(const std::string& url);
+    // Constructs a new Downloader instance and starts downloading data
+    // from url. Non-empty validators of cached are sent as If-None-Match
+    // and If-Modified-Since headers. The transfer fails if the connection
+    // is not established within CONNECT_TIMEOUT seconds, or if it stays
+    // below LOW_SPEED_LIMIT for stall_timeout seconds. Transfer errors
+    // are thrown as UpdateError when the stream is read.
+    Downloader(const std::string& url, const Validators& cached = {}, const long stall_timeout = STALL_TIMEOUT);
 
     Downloader(const Downloader&)            = delete;
     Downloader& operator=(const Downloader&) = delete;
 
-    Downloader(Downloader&& other);
-    Downloader& operator=(Downloader&& other);
+    Downloader(Downloader&& other)            = default;
+    Downloader& operator=(Downloader&& other) = default;
 
-    ~Downloader();
+    // Aborts the transfer if it is still in progress.
+    ~Downloader() = default;
 
-    // Returns a reference to the wrapped stream.
+    // Returns a reference to the wrapped stream. The stream rethrows
+    // errors raised by the transfer.
     std::istream& get() noexcept override final;
+
+    // Returns true if the server responded with 304 Not Modified,
+    // in which case the stream yields no data. Valid once the stream
+    // has reached end of file.
+    bool not_modified() const noexcept;
+
+    // Returns the validators of the response. Valid once the stream
+    // has reached end of file.
+    const Validators& validators() const noexcept;
 };
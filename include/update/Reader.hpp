@@ -1,15 +1,47 @@
 #pragma once
 
-#include <fstream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
 
 #include "Updater.hpp"
 
 // Class that provides data for cache update from a local file.
+// The file is memory-mapped, so its contents can be parsed in place.
 class Reader : public Updater {
-    std::ifstream file;
+    // Read-only mapping of the file. Also serves as the buffer
+    // of the wrapped stream. Kept on the heap to give the stream
+    // a stable buffer address when Reader is moved.
+    struct Mapping : std::streambuf {
+        // Base address of the mapping. Null for empty files.
+        const char* data;
+
+        // Size of the mapping in bytes.
+        size_t size;
+
+#if defined(_WIN32)
+        // File mapping object handle.
+        void* handle;
+#endif
+
+        std::istream stream;
+
+        // Maps the file at path. Throws Error if the file cannot be opened
+        // and UpdateError if it exceeds MAX_FSIZE or cannot be mapped.
+        Mapping(const std::string& path);
+
+        Mapping(const Mapping&)            = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        ~Mapping();
+    };
+
+    std::unique_ptr<Mapping> mapping;
 
 public:
-    // Constructs a new Reader instance and opens a file stream at path.
+    // Constructs a new Reader instance and maps the file at path.
     Reader(const std::string& path);
 
     Reader(const Reader&)            = delete;
@@ -18,6 +50,10 @@ public:
     Reader(Reader&& other)            = default;
     Reader& operator=(Reader&& other) = default;
 
-    // Returns a reference to the wrapped stream.
+    // Returns the contents of the file. The view remains valid
+    // for the lifetime of the Reader.
+    std::string_view data() const noexcept;
+
+    // Returns a reference to a stream reading the mapped file.
     std::istream& get() noexcept override final;
 };
@@ -1,25 +1,78 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
-#include <optional>
 #include <source_location>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "out.hpp"
 
+// Number of hex digits in a MAC address.
+constexpr size_t MAC_NIBBLES = 12;
+
+// Maximum number of candidate keys that construct_queries extracts
+// from a single address (MA-L, MA-M, MA-S and Docker's prefix).
+constexpr size_t MAX_QUERIES = 4;
+
+// MAC address decoded by parse_addr.
+struct MacAddr {
+    // Hex digits aligned to the left of a 48-bit integer.
+    int64_t value;
+
+    // Number of hex digits, up to MAC_NIBBLES.
+    size_t len;
+};
+
+// Candidate cache keys extracted from a single address. Keys are stored
+// inline, so that constructing queries does not allocate.
+class Queries {
+    std::array<int64_t, MAX_QUERIES> keys{};
+    size_t                           count = 0;
+
+public:
+    void push_back(const int64_t key) noexcept {
+        assert(count < MAX_QUERIES && "too many queries");
+        keys[count++] = key;
+    }
+
+    int64_t*       begin() noexcept { return keys.data(); }
+    int64_t*       end() noexcept { return keys.data() + count; }
+    const int64_t* begin() const noexcept { return keys.data(); }
+    const int64_t* end() const noexcept { return keys.data() + count; }
+
+    bool   empty() const noexcept { return count == 0; }
+    size_t size() const noexcept { return count; }
+
+    int64_t operator[](const size_t i) const noexcept { return keys[i]; }
+
+    // Sorts the keys in descending order, i.e. from the longest block
+    // of an address to the shortest.
+    void sort_descending() noexcept {
+        // The explicit bound lets the compiler see that sort stays within keys
+        std::ranges::sort(std::span{keys.data(), std::min(count, MAX_QUERIES)}, std::ranges::greater{});
+    }
+};
+
 // A helper function that appends the correct number of placeholders
 // to the sqlite statement in construction.
 std::string build_find_by_addr_stmt(const size_t length) noexcept;
 
-// Constructs a vector of all possible vendor identifiers that can be extracted
-// from addr. This is important in situations where user specifies
-// a full MAC address. Lookup by prefix is done by integer comparison.
-// Including device identifier in the converted integer would result in missed
-// searches. It is also important to trim address to the length
-// of the different blocks to get match.
-std::vector<int64_t> construct_queries(const std::string& addr);
+// Constructs all possible vendor identifiers that can be extracted
+// from addr, encoded with make_key. This is important in situations where
+// user specifies a full MAC address. Lookup by prefix is done by integer
+// comparison. Including device identifier in the converted integer would
+// result in missed searches. It is also important to trim address
+// to the length of the different blocks to get match.
+Queries construct_queries(const MacAddr& addr);
+
+// Parses addr with parse_addr and constructs queries from the result.
+Queries construct_queries(const std::string_view addr);
 
 // Returns a copy of str with escaped special characters. F (Format) parameter
 // determines the characters to escape and their replacements.
@@ -66,11 +119,6 @@ inline std::string fmt_loc(const std::source_location loc) noexcept {
     return std::string{loc.function_name()} + " (line " + std::to_string(loc.line()) + ')';
 }
 
-// Returns a vendor identifier block of length block_len extracted from addr.
-// If length of addr is lower than block_len, nullopt is returned instead.
-// Accepts addr without separators (101010).
-std::optional<std::string> get_ieee_block(const std::string& addr, const size_t block_len);
-
 // Helper function for has_spec_chars that returns a string_view containing
 // special characters for the specified F template parameter. This function
 // cannot be used for the regular format.
@@ -106,14 +154,67 @@ bool has_spec_chars(const std::string& str) {
     return false;
 }
 
-// Converts MAC prefix from string to an integer. Colon separators allowed.
-int64_t prefix_to_int(const std::string& prefix);
+// Returns true if str matches the SQL LIKE pattern. Mirrors SQLite semantics
+// with ESCAPE '\': '%' matches any sequence of characters, '_' matches
+// a single UTF-8 character and '\' escapes the following character.
+// Comparison is case-insensitive for ASCII letters only.
+bool like_match(std::string_view str, std::string_view pattern) noexcept;
+
+// Returns the runs of literal characters found between the wildcards
+// of LIKE pattern (see like_match), in order and with escape characters
+// removed.
+std::vector<std::string> like_literals(std::string_view pattern);
+
+// Translates LIKE pattern (see like_match) into an FTS5 query for a trigram
+// index. The query requires every literal run of at least 3 characters
+// found in the pattern, so it matches a superset of the strings matched
+// by '%' || pattern || '%'. Returns an empty string if the pattern
+// contains no such run, in which case the index cannot narrow the search.
+std::string trigram_query(std::string_view pattern);
+
+// Encodes MAC prefix consisting of len hex digits into a cache key.
+// The prefix is aligned to the left of a 48-bit MAC address and followed
+// by a 4-bit length tag, so that blocks of different widths never share
+// a key (000000 and 0000000 are distinct) and keys are ordered by address
+// first, then by length. For prefixes of the same address, a longer,
+// more specific block sorts after a shorter one.
+constexpr int64_t make_key(const int64_t prefix, const size_t len) noexcept {
+    return (prefix << (4 * (MAC_NIBBLES - len) + 4)) | static_cast<int64_t>(len);
+}
 
-// Converts integral MAC prefix to colon-separated string.
-std::string prefix_to_string(const int64_t prefix);
+// Returns name in the form stored in the norm column of the vendors table:
+// normalized as in FuzzyIndex::normalize, with trailing legal form
+// designations ("Inc", "Ltd", "Co.", ...) removed. Returns an empty string
+// if name contains no letters or digits.
+std::string normalize_name(const std::string_view name);
 
-// Removes ':' characters from addr.
-std::string remove_addr_separators(const std::string& addr);
+// Decodes MAC address in colon (00:11:22:33:44:55), dash (00-11-22-33-44-55),
+// dot (0011.2233.4455) or bare hex (001122334455) notation in a single pass,
+// without allocating. Separators are skipped wherever they appear, so partial
+// addresses and mixed notations are accepted. Hex digits past MAC_NIBBLES
+// are validated, but ignored. Throws Error if addr contains characters
+// other than hex digits and separators.
+MacAddr parse_addr(const std::string_view addr);
+
+// Converts MAC prefix from string to an integer. Colon separators allowed.
+// Does not allocate.
+int64_t prefix_to_int(const std::string_view prefix);
+
+// Converts integral MAC prefix to colon-separated string. The prefix is
+// zero-padded to len hex digits.
+std::string prefix_to_string(const int64_t prefix, const size_t len = 6);
 
 // Replaces "" (CSV escaped quotes) in str with ".
 void replace_escaped_quotes(std::string& str);
+
+// Decodes cache key created by make_key into MAC prefix and its length
+// in hex digits. Length tags exceeding MAC_NIBBLES are clamped.
+constexpr std::pair<int64_t, size_t> split_key(const int64_t key) noexcept {
+    const size_t len = std::min(static_cast<size_t>(key & 0xF), MAC_NIBBLES);
+    return {key >> (4 * (MAC_NIBBLES - len) + 4), len};
+}
+
+// Splits text into at most n blocks of similar size. Blocks end after
+// a newline character or at the end of text, so lines are never split.
+// Empty blocks are omitted.
+std::vector<std::string_view> split_lines(const std::string_view text, const size_t n);
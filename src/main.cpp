@@ -1,73 +1,343 @@
 #include <cstdlib>
 #include <curl/curl.h>
+#include <fstream>
 #include <iostream>
 #include <optional>
 #include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
 
 #include "FinalAction.hpp"
 #include "argparse/argparse.hpp"
 #include "cache/ConnR.hpp"
 #include "cache/ConnRW.hpp"
+#include "cache/Snapshot.hpp"
 #include "config.hpp"
 #include "dir.hpp"
 #include "exception.hpp"
 #include "out.hpp"
+#include "update/Decompressor.hpp"
 #include "update/Downloader.hpp"
 #include "update/Reader.hpp"
 
-// Presents results in the user-specified (or default) format.
-void display_results(const argparse::ArgumentParser& app, const std::ranges::input_range auto& results) {
-    const std::string format = (app.is_used("--out-format") ? app.get("--out-format") : "regular");
+// Writes results to std::cout in the user-specified (or default) format.
+// Results can be written in several portions, e.g. when streaming
+// the output of a bulk search. The closing part of the output is written
+// by the finish member function.
+class ResultWriter {
+    // Selected output format.
+    out::Format format;
+
+    // Signals whether any record has been written.
+    bool written;
+
+public:
+    // Selects the output format and writes the opening part of the output.
+    // If grouped is true, results are written with write_group.
+    // Throws if the format is unknown.
+    explicit ResultWriter(const argparse::ArgumentParser& app, const bool grouped = false) : written{false} {
+        const std::string fmt = (app.is_used("--out-format") ? app.get("--out-format") : "regular");
 
-    if (format == "regular") {
-        for (auto it = results.begin(); it != results.end(); it++) {
-            std::cout << *it << (std::next(it) == results.end() ? "\n" : "\n\n");
+        if (fmt == "regular") {
+            format = out::Format::Regular;
+            std::cout << out::regular;
+        } else if (fmt == "csv") {
+            format = out::Format::CSV;
+            std::cout << (grouped ? "Search Term," : "")
+                      << "MAC Prefix,Vendor Name,Private,Block Type,Last Update\n"
+                      << out::csv;
+        } else if (fmt == "json") {
+            format = out::Format::JSON;
+            std::cout << '[' << out::json;
+        } else if (fmt == "xml") {
+            format = out::Format::XML;
+            std::cout << R"(<MacAddressVendorMappings xmlns="http://www.cisco.com/server/spt">)"
+                      << out::xml;
+        } else {
+            throw errors::Error{"unknown output format '" + fmt + '\''};
         }
-        return;
     }
 
-    if (format == "csv") {
-        std::cout << "MAC Prefix,Vendor Name,Private,Block Type,Last Update\n"
-                  << out::csv;
+    // Writes a portion of results.
+    void write(std::ranges::input_range auto&& results) {
         for (const auto& v : results) {
-            std::cout << v << '\n';
+            switch (format) {
+            case out::Format::Regular: std::cout << (written ? "\n\n" : "") << v; break;
+            case out::Format::CSV:     std::cout << v << '\n'; break;
+            case out::Format::JSON:    std::cout << (written ? "," : "") << v; break;
+            case out::Format::XML:     std::cout << "\n\t" << v; break;
+            }
+            written = true;
         }
-        return;
     }
 
-    if (format == "json") {
-        std::cout << '[' << out::json;
-        for (auto it = results.begin(); it != results.end(); it++) {
-            std::cout << *it << (std::next(it) == results.end() ? "" : ",");
+    // Writes the results matched by a search term, labelled with the term:
+    // in a line preceding every record, in the first CSV column, or in
+    // a JSON object or XML element enclosing the results. Nothing is written
+    // if there are no results.
+    void write_group(const std::string& term, const VendorList& results) {
+        if (results.size() == 0) {
+            return;
+        }
+
+        switch (format) {
+        case out::Format::Regular:
+            for (const auto& v : results) {
+                std::cout << (written ? "\n\n" : "") << "Search term  " << term << '\n' << v;
+                written = true;
+            }
+            break;
+        case out::Format::CSV: {
+            const std::string field = has_spec_chars<out::Format::CSV>(term) || term.find(',') != std::string::npos
+                                        ? '"' + escape_spec_chars<out::Format::CSV>(term) + '"'
+                                        : term;
+
+            for (const auto& v : results) {
+                std::cout << field << ',' << v << '\n';
+            }
+            break;
         }
-        std::cout << "]\n";
-        return;
+        case out::Format::JSON: {
+            std::cout << (written ? "," : "") << R"({"searchTerm":")" << escape_spec_chars<out::Format::JSON>(term) << R"(","results":[)";
+
+            bool first = true;
+            for (const auto& v : results) {
+                std::cout << (first ? "" : ",") << v;
+                first = false;
+            }
+
+            std::cout << "]}";
+            break;
+        }
+        case out::Format::XML:
+            std::cout << "\n\t" << R"(<SearchTerm term=")" << escape_spec_chars<out::Format::XML>(term) << R"(">)";
+
+            for (const auto& v : results) {
+                std::cout << "\n\t\t" << v;
+            }
+
+            std::cout << "\n\t</SearchTerm>";
+            break;
+        }
+
+        written = true;
     }
 
-    if (format == "xml") {
-        std::cout << R"(<MacAddressVendorMappings xmlns="http://www.cisco.com/server/spt">)"
-                  << out::xml;
-        for (const auto& v : results) {
-            std::cout << "\n\t" << v;
+    // Writes the closing part of the output.
+    void finish() {
+        switch (format) {
+        case out::Format::Regular: std::cout << (written ? "\n" : ""); break;
+        case out::Format::CSV:     break;
+        case out::Format::JSON:    std::cout << "]\n"; break;
+        case out::Format::XML:     std::cout << "\n</MacAddressVendorMappings>\n"; break;
+        }
+    }
+};
+
+// Presents results in the user-specified (or default) format.
+void display_results(const argparse::ArgumentParser& app, std::ranges::input_range auto&& results) {
+    ResultWriter writer{app};
+    writer.write(results);
+    writer.finish();
+}
+
+// Returns a view of the records found by a most-specific search,
+// skipping addresses that do not belong to any block.
+auto found(const std::vector<std::optional<Vendor>>& results) {
+    return results
+         | std::views::filter([](const auto& v) { return v.has_value(); })
+         | std::views::transform([](const auto& v) -> const Vendor& { return *v; });
+}
+
+// Returns line without leading and trailing whitespace.
+std::string_view trim(const std::string_view line) {
+    const size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+}
+
+// Opens the search term file at path. Throws if the file cannot be read.
+std::ifstream open_input(const std::string& path) {
+    std::ifstream input{path};
+    if (!input.good()) {
+        throw errors::Error{"file '" + path + "' not found"};
+    }
+    return input;
+}
+
+// Reads MAC addresses from is, one per line, and resolves them in batches
+// of bounded size. Results of each batch are written and flushed before
+// the next one is read, so the memory usage does not depend on the input
+// size. Duplicate records are removed only within a batch. Blank lines
+// are skipped. If best is true, only the most specific block of every
+// address is written and duplicates are kept.
+void stream_addr(const argparse::ArgumentParser& app, const auto& source, std::istream& is, const bool best) {
+    constexpr size_t BATCH_SIZE = 4096;
+
+    ResultWriter writer{app};
+
+    std::vector<std::string> batch;
+    batch.reserve(BATCH_SIZE);
+
+    std::string line;
+
+    const auto flush_batch = [&] {
+        if (!batch.empty()) {
+            if (best) {
+                writer.write(found(source.find_best_by_addr(batch)));
+            } else if constexpr (requires { source.find_by_addr_batch(batch); }) {
+                writer.write(source.find_by_addr_batch(batch));
+            } else {
+                writer.write(source.find_by_addr(batch));
+            }
+            std::cout.flush();
+            batch.clear();
+        }
+    };
+
+    while (std::getline(is, line)) {
+        const std::string_view addr = trim(line);
+        if (addr.empty()) {
+            continue;
+        }
+        batch.emplace_back(addr);
+
+        if (batch.size() == BATCH_SIZE) {
+            flush_batch();
+        }
+    }
+
+    flush_batch();
+    writer.finish();
+}
+
+// Reads vendor names from is, one per line. Blank lines are skipped.
+// Names are searched for at once, so that long lists are resolved
+// in a single pass over the records.
+std::vector<std::string> read_names(std::istream& is) {
+    std::vector<std::string> names;
+
+    std::string line;
+
+    while (std::getline(is, line)) {
+        if (const std::string_view name = trim(line); !name.empty()) {
+            names.emplace_back(name);
         }
-        std::cout << "\n</MacAddressVendorMappings>\n";
-        return;
     }
 
-    throw errors::Error{"unknown output format '" + format + '\''};
+    return names;
+}
+
+// Keys of the validators of the downloaded data in the cache meta table.
+constexpr const char* ETAG_KEY          = "etag";
+constexpr const char* LAST_MODIFIED_KEY = "last_modified";
+
+// Stores the validators of the downloaded data in the database, so that
+// the next online update is skipped unless the data has changed. Validators
+// are removed if received is std::nullopt, e.g. after an update from
+// a local file.
+void store_validators(ConnRW& conn, const std::optional<Downloader::Validators>& received) {
+    const Downloader::Validators validators = received.value_or(Downloader::Validators{});
+
+    // Absent headers are not stored
+    const auto value = [](const std::string& v) { return v.empty() ? std::nullopt : std::optional{v}; };
+
+    conn.set_meta(ETAG_KEY, value(validators.etag));
+    conn.set_meta(LAST_MODIFIED_KEY, value(validators.last_modified));
 }
 
 // Updates cache at the specified db_path. If update_path holds string, the function
 // will update the database from local file instead of downloading data.
+// The file may be compressed with gzip or Zstandard.
+// The new database is built next to the current one and replaces it once
+// complete, so that concurrent lookups are not blocked by the update.
+// If the database is ready for use, the new one starts as its copy and only
+// the records changed by the update are written to it, as they are
+// received. The download is conditional on the validators stored
+// by the previous one, and the database is left untouched if the server
+// reports that the data has not changed. A source that holds no records,
+// or would remove most of them, is rejected and the database is left
+// untouched. The numbers of records added, changed and removed
+// are reported. The lookup snapshot is regenerated once the database
+// is updated.
 void update(const std::string& db_path, const std::optional<std::string>& update_fpath) {
-    ConnRW conn{db_path};
+    const std::string url           = "https://maclookup.app/downloads/csv-database/get-db";
+    const std::string snapshot_path = Snapshot::path_for(db_path);
+
+    bool                   ready = true;
+    Downloader::Validators cached;
+
+    try {
+        const ConnR conn{db_path};
+        cached = {conn.get_meta(ETAG_KEY).value_or(""), conn.get_meta(LAST_MODIFIED_KEY).value_or("")};
+    } catch (const errors::CacheError&) {
+        ready = false;
+    }
+
+    ConnRW::Changes changes{};
+
+    // Merges the records read from is into a copy of a ready database,
+    // or inserts them into a new one
+    const auto fill = [&](ConnRW& conn, std::istream& is) {
+        if (ready) {
+            changes = conn.merge(is);
+        } else {
+            conn.insert(is, true);
+        }
+    };
+
+    size_t records;
 
     if (!update_fpath) {
         const auto cleanup = finally([] { curl_global_cleanup(); });
-        conn.insert(Downloader{"https://maclookup.app/downloads/csv-database/get-db"}.get(), true);
+        Downloader downloader{url, cached};
+
+        // A 304 Not Modified response has no body. The first byte is awaited
+        // before copying the database, which is not needed in that case.
+        if (downloader.get().peek() == std::char_traits<char>::eof() && downloader.not_modified()) {
+            std::cout << "Database is up to date\n";
+
+            // Written by an earlier version of the application or removed
+            try {
+                const Snapshot snapshot{snapshot_path, db_path};
+            } catch (const errors::CacheError&) {
+                Snapshot::write(snapshot_path, db_path, ConnR{db_path}.export_records());
+            }
+            return;
+        }
+
+        records = ConnRW::rebuild(db_path, [&](ConnRW& conn) {
+            fill(conn, downloader.get());
+            store_validators(conn, downloader.validators());
+        }, ready);
     } else {
-        conn.insert(Reader{*update_fpath}.get(), true);
+        Reader file{*update_fpath};
+
+        records = ConnRW::rebuild(db_path, [&](ConnRW& conn) {
+            if (Decompressor::detect(file.data()) != Decompressor::Format::None) {
+                // Records are parsed as they are decompressed
+                fill(conn, Decompressor{std::move(file)}.get());
+            } else if (ready) {
+                fill(conn, file.get());
+            } else {
+                // Parsed in place, in parallel
+                conn.insert(file.data(), true);
+            }
+            store_validators(conn, std::nullopt);
+        }, ready);
     }
+
+    // The record inserted by customize_db is not counted
+    if (!ready) {
+        changes.added = records;
+    }
+
+    std::cout << changes.added << " added, " << changes.changed << " changed, " << changes.removed << " removed\n";
+
+    Snapshot::write(snapshot_path, db_path, ConnR{db_path}.export_records());
 }
 
 int main(int argc, char* argv[]) {
@@ -81,8 +351,14 @@ int main(int argc, char* argv[]) {
 
     argparse::ArgumentParser sc_addr{"addr"};
     sc_addr.add_description("Search by MAC address.");
+    sc_addr.add_argument("-b", "--best")
+        .help("Report only the most specific block (MA-S over MA-M over MA-L) for each address.")
+        .flag();
+    sc_addr.add_argument("-i", "--input")
+        .help("Read MAC addresses from a file, one per line.")
+        .metavar("PATH");
     sc_addr.add_argument("addr")
-        .help("MAC address (e.g. \"000000\", \"01:23:45:67:89:01\").")
+        .help("MAC address (e.g. \"000000\", \"01:23:45:67:89:01\"). Use \"-\" to read addresses from standard input.")
         .remaining();
     app.add_subparser(sc_addr);
 
@@ -92,6 +368,26 @@ int main(int argc, char* argv[]) {
 
     argparse::ArgumentParser sc_name{"name"};
     sc_name.add_description("Search by vendor name.");
+    sc_name.add_argument("-e", "--exact")
+        .help("Find vendor names equal to the given ones, ignoring case, punctuation and legal form suffixes.")
+        .flag();
+    sc_name.add_argument("-F", "--fuzzy")
+        .help("Find vendor names similar to the given ones, from the closest match.")
+        .flag();
+    sc_name.add_argument("-g", "--group")
+        .help("Group the results by the vendor name they matched. A record matching several names is reported for each of them.")
+        .flag();
+    sc_name.add_argument("-i", "--input")
+        .help("Read vendor names from a file, one per line.")
+        .metavar("PATH");
+    sc_name.add_argument("-p", "--prefix")
+        .help("Find vendor names starting with the given ones, ignoring case, punctuation and legal form suffixes.")
+        .flag();
+    sc_name.add_argument("-t", "--top")
+        .help("Number of closest vendor names reported for each name searched with --fuzzy.")
+        .metavar("K")
+        .default_value(size_t{5})
+        .scan<'u', size_t>();
     sc_name.add_argument("name")
         .help("Vendor name (e.g. \"xerox\", \"xerox corporation\").")
         .remaining();
@@ -125,16 +421,82 @@ int main(int argc, char* argv[]) {
             return EXIT_SUCCESS;
         }
 
-        const ConnR conn{cache_path};
+        // Runs the chosen search against either Snapshot or ConnR.
+        const auto search = [&](const auto& source) {
+            if (app.is_subcommand_used(sc_addr)) {
+                const bool best = sc_addr.get<bool>("--best");
+
+                if (sc_addr.is_used("--input")) {
+                    std::ifstream input = open_input(sc_addr.get<std::string>("--input"));
+                    stream_addr(app, source, input, best);
+                    return;
+                }
+
+                const auto addresses = sc_addr.get<std::vector<std::string>>("addr");
+
+                if (addresses.size() == 1 && addresses[0] == "-") {
+                    stream_addr(app, source, std::cin, best);
+                } else if (best) {
+                    display_results(app, found(source.find_best_by_addr(addresses)));
+                } else {
+                    display_results(app, source.find_by_addr(addresses));
+                }
+            } else if (app.is_subcommand_used(sc_name)) {
+                std::vector<std::string> names;
+
+                if (sc_name.is_used("--input")) {
+                    std::ifstream input = open_input(sc_name.get<std::string>("--input"));
+                    names = read_names(input);
+                } else {
+                    names = sc_name.get<std::vector<std::string>>("name");
+                }
+
+                const int modes = sc_name.get<bool>("--exact") + sc_name.get<bool>("--fuzzy") + sc_name.get<bool>("--prefix");
+
+                if (modes > 1) {
+                    throw errors::Error{"--exact, --fuzzy and --prefix cannot be combined"};
+                }
+
+                if (modes > 0 && sc_name.get<bool>("--group")) {
+                    throw errors::Error{"--group cannot be combined with --exact, --fuzzy or --prefix"};
+                }
+
+                if (sc_name.get<bool>("--exact")) {
+                    display_results(app, source.find_exact(names));
+                } else if (sc_name.get<bool>("--fuzzy")) {
+                    display_results(app, source.find_fuzzy(names, sc_name.get<size_t>("--top")));
+                } else if (sc_name.get<bool>("--prefix")) {
+                    display_results(app, source.find_prefix(names));
+                } else if (sc_name.get<bool>("--group")) {
+                    const auto groups = source.find_by_name_grouped(names);
+
+                    ResultWriter writer{app, true};
+                    for (size_t i = 0; i < names.size(); i++) {
+                        writer.write_group(names[i], groups[i]);
+                    }
+                    writer.finish();
+                } else {
+                    display_results(app, source.find_by_name(names));
+                }
+            } else if (app.is_subcommand_used(sc_export)) {
+                display_results(app, source.export_records());
+            } else {
+                throw errors::Error{"no action specified"};
+            }
+        };
+
+        std::optional<Snapshot> snapshot;
+
+        try {
+            snapshot.emplace(Snapshot::path_for(cache_path), cache_path);
+        } catch (const errors::CacheError&) {
+            // Snapshot is missing or outdated - fall back to the database.
+        }
 
-        if (app.is_subcommand_used(sc_addr)) {
-            display_results(app, conn.find_by_addr(sc_addr.get<std::vector<std::string>>("addr")));
-        } else if (app.is_subcommand_used(sc_name)) {
-            display_results(app, conn.find_by_name(sc_name.get<std::vector<std::string>>("name")));
-        } else if (app.is_subcommand_used(sc_export)) {
-            display_results(app, conn.export_records());
+        if (snapshot) {
+            search(*snapshot);
         } else {
-            throw errors::Error{"no action specified"};
+            search(ConnR{cache_path});
         }
     } catch (const errors::Error& e) {
         std::cerr << e << '\n';
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+#include "Channel.hpp"
+
+TEST_CASE("Channel") {
+    SECTION("items are popped in order") {
+        constexpr int COUNT = 1000;
+
+        Channel<int> ch{4};
+
+        std::thread producer{[&] {
+            for (int i = 0; i < COUNT; i++) {
+                ch.push(i);
+            }
+            ch.close();
+        }};
+
+        std::vector<int> received;
+        while (const auto item = ch.pop()) {
+            received.push_back(*item);
+        }
+
+        producer.join();
+
+        REQUIRE(received.size() == COUNT);
+        for (int i = 0; i < COUNT; i++) {
+            REQUIRE(received[i] == i);
+        }
+    }
+
+    SECTION("items pushed before close are kept") {
+        Channel<int> ch{4};
+
+        REQUIRE(ch.push(1));
+        REQUIRE(ch.push(2));
+        ch.close();
+
+        REQUIRE_FALSE(ch.push(3));
+        REQUIRE(ch.pop() == 1);
+        REQUIRE(ch.pop() == 2);
+        REQUIRE_FALSE(ch.pop().has_value());
+    }
+
+    SECTION("close releases a blocked producer") {
+        Channel<int> ch{1};
+
+        REQUIRE(ch.push(0));
+
+        bool pushed = true;
+
+        std::thread producer{[&] { pushed = ch.push(1); }};
+
+        ch.close();
+        producer.join();
+
+        REQUIRE_FALSE(pushed);
+    }
+}
@@ -3,15 +3,22 @@
 
 #include <algorithm>
 #include <array>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <map>
+#include <optional>
 #include <set>
+#include <sstream>
 #include <sqlite3.h>
 
+#include "NameMatcher.hpp"
 #include "cache/ConnR.hpp"
 #include "cache/ConnRW.hpp"
 #include "cache/Stmt.hpp"
 #include "exception.hpp"
+#include "update/Reader.hpp"
+#include "utils.hpp"
 
 // Tests the ability of ConnRW class to correctly insert records into the cache
 // using a local file.
@@ -28,7 +35,7 @@ TEST_CASE("ConnRW::insert") {
 
     REQUIRE_NOTHROW(conn_rw.insert(good_file, false));
 
-    Stmt stmt{conn_rw.get(), "SELECT * FROM vendors"};
+    Stmt stmt{conn_rw.get(), "SELECT * FROM vendor_rows"};
 
     std::vector<Vendor> out;
 
@@ -44,10 +51,316 @@ TEST_CASE("ConnRW::insert") {
         REQUIRE(found);
     }
 
+    // Names are normalized on insert, empty ones to NULL
+    Stmt norm_stmt{conn_rw.get(), "SELECT norm FROM vendors LEFT JOIN names ON names.id = vendors.name_id ORDER BY prefix"};
+
+    std::vector<std::string> norms;
+
+    while (norm_stmt.step() == SQLITE_ROW) {
+        norms.emplace_back(norm_stmt.get_col<std::string>(0));
+    }
+
+    REQUIRE(norms == std::vector<std::string>{"cisco systems", "", "invendis technologies india"});
+
+    REQUIRE_NOTHROW(norm_stmt.reset());
     REQUIRE_NOTHROW(conn_rw.clear_table());
     REQUIRE_NOTHROW(stmt.reset());
 }
 
+// Ensures that CSV data parsed in place is stored the same way as a stream.
+TEST_CASE("ConnRW::insert(std::string_view)") {
+    const auto export_all = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "SELECT * FROM vendor_rows ORDER BY prefix"};
+
+        std::vector<Vendor> out;
+        while (stmt.step() == SQLITE_ROW) {
+            out.emplace_back(stmt.get_row());
+        }
+        return out;
+    };
+
+    ConnRW from_stream{"file:memdb_connrw_insert_stream?mode=memory&cache=shared", true};
+    ConnRW from_view{"file:memdb_connrw_insert_view?mode=memory&cache=shared", true};
+
+    std::ostringstream warnings;
+
+    std::ifstream good_file{"testdata/update.csv"};
+    REQUIRE_NOTHROW(from_stream.insert(good_file, true, warnings));
+
+    // No trailing newline, escaped quotes and an empty line
+    const std::string csv = "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n"
+                            "2C:7A:FE,\"IEE&E \"\"Black\"\" ops\",false,MA-L,2010/07/26\n\n"
+                            "00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17";
+
+    REQUIRE_NOTHROW(from_view.insert(Reader{"testdata/update.csv"}.data(), true, warnings));
+    REQUIRE(export_all(from_view) == export_all(from_stream));
+
+    REQUIRE_NOTHROW(from_view.insert(csv, false));
+
+    std::stringstream ss{csv};
+    REQUIRE_NOTHROW(from_stream.insert(ss, false));
+    REQUIRE(export_all(from_view) == export_all(from_stream));
+
+    REQUIRE_THROWS_AS(from_view.insert("Header\n00:00:00,\"IEE&E ,false,MA-L,\n", false), errors::QuotedTermSeqError);
+}
+
+// Ensures that CSV data split into blocks parsed on several threads is stored
+// the same way as a stream, and that parsing errors are reported.
+TEST_CASE("ConnRW::insert(std::string_view): parallel") {
+    const auto export_all = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "SELECT * FROM vendor_rows ORDER BY prefix"};
+
+        std::vector<Vendor> out;
+        while (stmt.step() == SQLITE_ROW) {
+            out.emplace_back(stmt.get_row());
+        }
+        return out;
+    };
+
+    // Large enough to be split into several blocks
+    std::string csv = "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n";
+    for (int64_t i = 0; i < 8000; i++) {
+        csv += prefix_to_string(i, 6) + ",\"Vendor \"\"" + std::to_string(i % 100) + "\"\" Inc, Ltd\",false,MA-L,2015/11/17\n";
+    }
+
+    ConnRW from_stream{"file:memdb_connrw_insert_par_stream?mode=memory&cache=shared", true};
+    ConnRW from_view{"file:memdb_connrw_insert_par_view?mode=memory&cache=shared", true};
+
+    std::stringstream ss{csv};
+    REQUIRE_NOTHROW(from_stream.insert(ss, false));
+    REQUIRE_NOTHROW(from_view.insert(csv, false, std::cerr, 4));
+
+    const auto stored = export_all(from_view);
+
+    REQUIRE(stored.size() == 8000);
+    REQUIRE(stored == export_all(from_stream));
+
+    // Malformed line in the last block
+    ConnRW failing{"file:memdb_connrw_insert_par_failing?mode=memory&cache=shared", true};
+    REQUIRE_THROWS_AS(failing.insert(csv + "00:00:0D,FIBRONICS LTD.\n", false, std::cerr, 4), errors::UnquotedTermError);
+}
+
+// Ensures that records inserted in bulk-load mode, by multi-row statements,
+// are stored the same way as the ones inserted one at a time, and that
+// the pragmas are restored afterwards.
+TEST_CASE("ConnRW::begin_bulk_load") {
+    const auto export_all = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "SELECT * FROM vendor_rows ORDER BY prefix"};
+
+        std::vector<Vendor> out;
+        while (stmt.step() == SQLITE_ROW) {
+            out.emplace_back(stmt.get_row());
+        }
+        return out;
+    };
+
+    const auto pragma = [](ConnRW& conn, const std::string& stmt_str) {
+        Stmt stmt{conn.get(), stmt_str};
+        REQUIRE(stmt.step() == SQLITE_ROW);
+        return stmt.get_col<std::string>(0);
+    };
+
+    // Shared and empty names, private records, and prefixes out of order
+    std::string csv = "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n";
+    for (int64_t i = 0; i < 1000; i++) {
+        const int64_t prefix = (i * 7919) % 1000;
+
+        if (prefix % 10 == 0) {
+            csv += prefix_to_string(prefix, 6) + ",,true,,0001/01/01\n";
+        } else {
+            csv += prefix_to_string(prefix, 6) + ",\"Vendor " + std::to_string(prefix % 30) + ", Inc\",false,MA-L,2015/11/17\n";
+        }
+    }
+
+    ConnRW reference{"file:memdb_connrw_bulk_reference?mode=memory&cache=shared", true};
+
+    // Warnings about the records missing from csv
+    std::ostringstream warnings;
+
+    std::stringstream ref_ss{csv};
+    REQUIRE_NOTHROW(reference.insert(ref_ss, true, warnings));
+
+    // Along with the custom Docker record
+    const auto expected = export_all(reference);
+    REQUIRE(expected.size() == 1001);
+
+    const std::string db_path = "testdata/bulk_load.db";
+    std::filesystem::remove(db_path);
+
+    ConnRW conn{db_path, true};
+
+    // Settings other than the defaults are restored as they were
+    pragma(conn, "PRAGMA journal_mode = TRUNCATE");
+    REQUIRE(sqlite3_exec(conn.get(), "PRAGMA synchronous = NORMAL; PRAGMA cache_size = -4000", nullptr, nullptr, nullptr) == SQLITE_OK);
+
+    // Widths that leave partial statements, and one above the limit
+    for (const size_t width : {size_t{2}, size_t{7}, ConnRW::BULK_WIDTH, ConnRW::MAX_BULK_WIDTH + 1}) {
+        CAPTURE(width);
+
+        REQUIRE_NOTHROW(conn.begin_bulk_load(width));
+        REQUIRE(pragma(conn, "PRAGMA journal_mode") == "memory");
+
+        std::stringstream ss{csv};
+        REQUIRE_NOTHROW(conn.insert(ss, true, warnings));
+        REQUIRE(export_all(conn) == expected);
+
+        REQUIRE_NOTHROW(conn.insert(csv, true, warnings));
+        REQUIRE(export_all(conn) == expected);
+
+        REQUIRE_NOTHROW(conn.end_bulk_load());
+        REQUIRE(pragma(conn, "PRAGMA journal_mode") == "truncate");
+        REQUIRE(pragma(conn, "PRAGMA synchronous") == "1");
+        REQUIRE(pragma(conn, "PRAGMA cache_size") == "-4000");
+        REQUIRE(pragma(conn, "PRAGMA locking_mode") == "normal");
+    }
+
+    // A malformed line rolls back the load, along with the cleared records
+    REQUIRE_NOTHROW(conn.begin_bulk_load());
+
+    std::stringstream malformed{csv + "00:00:0D,FIBRONICS LTD.\n"};
+    REQUIRE_THROWS_AS(conn.insert(malformed, true, warnings), errors::UnquotedTermError);
+    REQUIRE(conn.rollback() == SQLITE_OK);
+
+    REQUIRE(export_all(conn) == expected);
+    REQUIRE_NOTHROW(conn.end_bulk_load());
+}
+
+// Ensures that merge writes only the changed records, leaving the database
+// in the state a full load would, along with the modifications
+// of customize_db and the name index.
+TEST_CASE("ConnRW::merge") {
+    const auto export_all = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "SELECT * FROM vendor_rows ORDER BY prefix"};
+
+        std::vector<Vendor> out;
+        while (stmt.step() == SQLITE_ROW) {
+            out.emplace_back(stmt.get_row());
+        }
+        return out;
+    };
+
+    const auto count_names = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "SELECT COUNT(*) FROM names"};
+        REQUIRE(stmt.step() == SQLITE_ROW);
+        return stmt.get_col<int64_t>(0);
+    };
+
+    const auto check_index = [](ConnRW& conn) {
+        Stmt stmt{conn.get(), "INSERT INTO names_fts (names_fts, rank) VALUES ('integrity-check', 1)"};
+        return stmt.step();
+    };
+
+    const std::string header = "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n";
+
+    const std::string base = header +
+                             "00:00:0C,\"Cisco Systems, Inc\",false,MA-L,2015/11/17\n"
+                             "00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17\n"
+                             "00:48:54,,true,,0001/01/01\n"
+                             "08:00:27,PCS Systemtechnik GmbH,false,MA-L,2016/10/30\n"
+                             "52:54:00,,true,,0001/01/01\n";
+
+    // One record changed, one removed and one added
+    const std::string next = header +
+                             "00:00:0C,\"Cisco Systems, Inc\",false,MA-L,2016/01/01\n"
+                             "00:00:AA,XEROX CORPORATION,false,MA-L,2015/11/17\n"
+                             "00:48:54,,true,,0001/01/01\n"
+                             "08:00:27,PCS Systemtechnik GmbH,false,MA-L,2016/10/30\n"
+                             "52:54:00,,true,,0001/01/01\n";
+
+    ConnRW conn{"file:memdb_connrw_merge?mode=memory&cache=shared", true};
+    ConnRW full{"file:memdb_connrw_merge_full?mode=memory&cache=shared", true};
+
+    std::ostringstream warnings;
+
+    const auto merge = [&](const std::string& csv) {
+        std::istringstream is{csv};
+        return conn.merge(is, warnings);
+    };
+
+    REQUIRE_NOTHROW(conn.insert(base, true, warnings));
+    REQUIRE_NOTHROW(full.insert(next, true, warnings));
+    REQUIRE(warnings.str().empty());
+
+    ConnRW::Changes changes{};
+
+    REQUIRE_NOTHROW(changes = merge(next));
+    CHECK(changes.added == 1);
+    CHECK(changes.changed == 1);
+    CHECK(changes.removed == 1);
+
+    // Modifications of customize_db are neither repeated nor reported
+    REQUIRE(warnings.str().empty());
+    REQUIRE(export_all(conn) == export_all(full));
+    REQUIRE(count_names(conn) == count_names(full));
+    REQUIRE(check_index(conn) == SQLITE_DONE);
+
+    const ConnR conn_r{"file:memdb_connrw_merge?mode=memory&cache=shared", true};
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"xerox"}).size() == 1);
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"fibronics"}).size() == 0);
+
+    // Nothing changed
+    REQUIRE_NOTHROW(changes = merge(next));
+    CHECK(changes.added == 0);
+    CHECK(changes.changed == 0);
+    CHECK(changes.removed == 0);
+    REQUIRE(export_all(conn) == export_all(full));
+
+    // A modified record changed by the data source is modified again
+    std::string renamed = next;
+    renamed.replace(renamed.find("PCS Systemtechnik GmbH"), 22, "Oracle Corporation");
+
+    REQUIRE_NOTHROW(changes = merge(renamed));
+    CHECK(changes.changed == 1);
+    REQUIRE(conn_r.find_exact(std::vector<std::string>{"oracle corporation (virtualbox)"}).size() == 1);
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"pcs"}).size() == 0);
+    REQUIRE(check_index(conn) == SQLITE_DONE);
+    REQUIRE(warnings.str().empty());
+
+    // Malformed data leaves the records intact
+    const auto before       = export_all(conn);
+    const auto names_before = count_names(conn);
+    REQUIRE_THROWS_AS(merge(next + "00:00:0D,FIBRONICS LTD.\n"), errors::UnquotedTermError);
+    REQUIRE(export_all(conn) == before);
+
+    // So do a source without records and one that would remove most of them
+    for (const std::string& csv : {std::string{}, header}) {
+        CAPTURE(csv);
+
+        REQUIRE_THROWS_MATCHES(
+            merge(csv),
+            errors::UpdateError,
+            Catch::Matchers::Message("update source contains no records")
+        );
+        REQUIRE(export_all(conn) == before);
+    }
+
+    REQUIRE_THROWS_MATCHES(
+        merge(header + "00:00:AA,XEROX CORPORATION,false,MA-L,2015/11/17\n"),
+        errors::UpdateError,
+        Catch::Matchers::Message("update source would remove 4 of 6 records")
+    );
+    REQUIRE(export_all(conn) == before);
+
+    // Even once records of earlier batches are written
+    std::string long_source = next;
+    for (int i = 0; i < 2000; i++) {
+        long_source += prefix_to_string(0xA00000 + i) + ",Vendor " + std::to_string(i) + ",false,MA-L,2015/11/17\n";
+    }
+
+    REQUIRE_THROWS_AS(merge(long_source + "00:00:0D,FIBRONICS LTD.\n"), errors::UnquotedTermError);
+    REQUIRE(export_all(conn) == before);
+    REQUIRE(count_names(conn) == names_before);
+    REQUIRE(check_index(conn) == SQLITE_DONE);
+
+    // So does a record repeated in the source
+    REQUIRE_THROWS_AS(merge(next + "00:00:AA,XEROX CORPORATION,false,MA-L,2015/11/17\n"), errors::CacheError);
+    REQUIRE(export_all(conn) == before);
+
+    // The connection remains usable
+    REQUIRE_NOTHROW(changes = merge(renamed));
+    CHECK(changes.removed == 0);
+}
+
 TEST_CASE("ConnRW::customize_db: success") {
     const std::string db_path = "file:connrw_customize_db_success?mode=memory&cache=shared";
 
@@ -79,7 +392,7 @@ TEST_CASE("ConnRW::customize_db: success") {
     CAPTURE(err_messages);
     REQUIRE(err_messages.empty());
 
-    Stmt stmt{conn.get(), "SELECT * FROM vendors"};
+    Stmt stmt{conn.get(), "SELECT * FROM vendor_rows"};
 
     std::vector<Vendor> out;
 
@@ -97,6 +410,23 @@ TEST_CASE("ConnRW::customize_db: success") {
         CAPTURE(c);
         REQUIRE(found);
     }
+
+    // Names replaced by the modifications are removed from the dictionary
+    Stmt count{conn.get(), "SELECT COUNT(*) FROM names"};
+    REQUIRE(count.step() == SQLITE_ROW);
+    REQUIRE(count.get_col<int64_t>(0) == 3);
+
+    // Name index reflects the modified and inserted names
+    const ConnR conn_r{db_path, true};
+
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"virtualbox"}).size() == 1);
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"qemu/kvm"}).size() == 1);
+    REQUIRE(conn_r.find_by_name(std::vector<std::string>{"docker"}).size() == 1);
+
+    // Normalized names are updated along with the modified ones
+    REQUIRE(conn_r.find_exact(std::vector<std::string>{"pcs systemtechnik gmbh (virtualbox)"}).size() == 1);
+    REQUIRE(conn_r.find_exact(std::vector<std::string>{"qemu kvm"}).size() == 1);
+    REQUIRE(conn_r.find_prefix(std::vector<std::string>{"docker"}).size() == 1);
 }
 
 TEST_CASE("ConnRW::customize_db: warnings") {
@@ -111,8 +441,8 @@ TEST_CASE("ConnRW::customize_db: warnings") {
     REQUIRE_NOTHROW(conn.insert(ss, true, cerr_capture));
 
     const std::array<std::string, 3> expected = {
-        "[ customize_db ] UPDATE vendors SET name = 'QEMU/KVM' WHERE prefix = 0x525400: unexpected number of changes (0)",
-        "[ customize_db ] UPDATE vendors SET name = name || ' (VirtualBox)' WHERE prefix = 0x080027: unexpected number of changes (0)",
+        "[ customize_db ] 52:54:00: unexpected number of changes (0)",
+        "[ customize_db ] 08:00:27: unexpected number of changes (0)",
         "[ insert_row ] step: (19) constraint failed",
     };
 
@@ -212,6 +542,140 @@ TEST_CASE("ConnRW destruction") {
     REQUIRE(stmt.get_col<int>(0) == 0);
 }
 
+// Ensures that the rebuilt cache replaces the database only if it is
+// complete, while connections to the old database keep reading it.
+TEST_CASE("ConnRW::rebuild") {
+    const std::string db_path = "testdata/rebuild.db";
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    const auto count = [](const ConnR& conn) { return conn.export_records().size(); };
+
+    const ConnR old_conn{db_path, true};
+    REQUIRE(count(old_conn) == 3);
+
+    // Neither a failed fill nor a source without records replaces
+    // the database
+    REQUIRE_THROWS_AS(ConnRW::rebuild(db_path, [](ConnRW& conn) {
+        std::ifstream malformed_file{"testdata/malformed.csv"};
+        conn.insert(malformed_file, false);
+    }), errors::QuotedTermSeqError);
+
+    for (const std::string_view csv : {"", "Mac Prefix,Vendor Name,Private,Block Type,Last Update\n"}) {
+        CAPTURE(csv);
+
+        REQUIRE_THROWS_MATCHES(
+            ConnRW::rebuild(db_path, [&](ConnRW& conn) {
+                std::ostringstream err;
+                conn.insert(csv, true, err);
+            }),
+            errors::UpdateError,
+            Catch::Matchers::Message("update source contains no records")
+        );
+    }
+
+    REQUIRE_FALSE(std::filesystem::exists(db_path + ".tmp"));
+    REQUIRE(count(ConnR{db_path, true}) == 3);
+
+    size_t records = 0;
+
+    // A long-running fill does not block readers of the database
+    REQUIRE_NOTHROW(records = ConnRW::rebuild(db_path, [&](ConnRW& conn) {
+        std::ostringstream err;
+        std::ifstream      good_file{"testdata/update.csv"};
+        conn.insert(good_file, true, err);
+
+        REQUIRE(count(ConnR{db_path, true}) == 3);
+    }));
+
+    // Records of update.csv, without the custom Docker record
+    REQUIRE(records == 3);
+
+    REQUIRE_FALSE(std::filesystem::exists(db_path + ".tmp"));
+
+    // The old connection still reads the replaced database
+    REQUIRE(count(old_conn) == 3);
+
+    const ConnR new_conn{db_path, true};
+
+    // Records of update.csv, along with the custom Docker record
+    REQUIRE(count(new_conn) == 4);
+    REQUIRE(new_conn.version() == Conn::EXPECTED_CACHE_VERSION);
+
+    // A merge starts from a copy of the database, which is replaced only
+    // if the merge succeeds
+    REQUIRE_THROWS_AS(ConnRW::rebuild(db_path, [](ConnRW& conn) {
+        std::ostringstream err;
+        std::ifstream      malformed_file{"testdata/malformed.csv"};
+        conn.merge(malformed_file, err);
+    }, true), errors::QuotedTermSeqError);
+
+    REQUIRE_FALSE(std::filesystem::exists(db_path + ".tmp"));
+    REQUIRE(count(ConnR{db_path, true}) == 4);
+
+    std::ifstream      good_file{"testdata/update.csv"};
+    std::istringstream merged{std::string{std::istreambuf_iterator<char>{good_file}, {}} + "00:00:AA,XEROX CORPORATION,false,MA-L,2015/11/17\n"};
+
+    ConnRW::Changes changes{};
+
+    REQUIRE_NOTHROW(records = ConnRW::rebuild(db_path, [&](ConnRW& conn) {
+        std::ostringstream err;
+        changes = conn.merge(merged, err);
+
+        // Readers do not wait for the merge, while other writers cannot
+        // change the copied records
+        REQUIRE(count(ConnR{db_path, true}) == 4);
+
+        sqlite3* writer = nullptr;
+        REQUIRE(sqlite3_open_v2(db_path.c_str(), &writer, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK);
+        CHECK(sqlite3_exec(writer, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) == SQLITE_BUSY);
+        sqlite3_close(writer);
+    }, true));
+
+    CHECK(changes.added == 1);
+    CHECK(changes.changed == 0);
+    CHECK(changes.removed == 0);
+    REQUIRE(records == 4);
+
+    REQUIRE_FALSE(std::filesystem::exists(db_path + ".tmp"));
+    REQUIRE(count(ConnR{db_path, true}) == 5);
+}
+
+TEST_CASE("ConnRW::set_meta, ConnR::get_meta") {
+    const std::string db_path = "testdata/meta.db";
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    {
+        const ConnR conn_r{db_path, true};
+        ConnRW      conn_rw{db_path, true};
+
+        REQUIRE_FALSE(conn_r.get_meta("etag"));
+
+        REQUIRE_NOTHROW(conn_rw.set_meta("etag", "\"v1\""));
+        REQUIRE(conn_r.get_meta("etag") == "\"v1\"");
+
+        REQUIRE_NOTHROW(conn_rw.set_meta("etag", "\"v2\""));
+        REQUIRE(conn_r.get_meta("etag") == "\"v2\"");
+
+        REQUIRE_NOTHROW(conn_rw.set_meta("etag", std::nullopt));
+        REQUIRE_FALSE(conn_r.get_meta("etag"));
+
+        // Removing a missing key is not an error
+        REQUIRE_NOTHROW(conn_rw.set_meta("etag", std::nullopt));
+    }
+
+    // Stored along with the records of a rebuilt cache
+    REQUIRE_NOTHROW(ConnRW::rebuild(db_path, [](ConnRW& conn) {
+        std::ostringstream err;
+        std::ifstream      good_file{"testdata/update.csv"};
+        conn.insert(good_file, true, err);
+        conn.set_meta("etag", "\"v3\"");
+    }));
+
+    REQUIRE(ConnR{db_path, true}.get_meta("etag") == "\"v3\"");
+}
+
 TEST_CASE("undefined Registry values") {
     const std::vector<Vendor> expected = {
         {0x000000, "", true, Registry::Unknown, ""},
@@ -220,15 +684,15 @@ TEST_CASE("undefined Registry values") {
 
     const ConnR conn{"testdata/poisoned.db", true};
 
-    std::vector<Vendor> out;
+    VendorList out;
 
     REQUIRE_NOTHROW(out = conn.export_records());
-    REQUIRE(out == expected);
+    REQUIRE(std::ranges::equal(out, expected));
 }
 
 TEST_CASE("ConnR::export_records") {
-    const ConnR         conn{"testdata/sample.db", true};
-    std::vector<Vendor> out = conn.export_records();
+    const ConnR conn{"testdata/sample.db", true};
+    VendorList  out = conn.export_records();
     REQUIRE(out.size() == 3);
 }
 
@@ -251,6 +715,7 @@ TEST_CASE("ConnR::find_by_addr") {
         {{"00:00:aa:12:34:56"}, {xerox}},                         // lower case hex, separators
         {{"00:00:0C", "00:00:0C"}, {cisco}},                      // duplicate search terms
         {{"00:00:0C", "12:34:56"}, {cisco}},                      // one unknown
+        {{"00:00:AA", "00:00:0C", "00:00:aa"}, {cisco, xerox}},   // results sorted and de-duplicated
         {{"012345"}, {}},                                         // valid, not found
         {{"000000", "741AE0C", "0050C2003", "024201234567"}, {}}, // trigger all placeholders in the pool
     };
@@ -259,10 +724,10 @@ TEST_CASE("ConnR::find_by_addr") {
         CAPTURE(input.size());
         CAPTURE(expected.size());
 
-        const std::set<Vendor> results = conn.find_by_addr(input);
+        const VendorList results = conn.find_by_addr(input);
 
         CAPTURE(results.size());
-        REQUIRE(results == expected);
+        REQUIRE(std::ranges::equal(results, expected));
     }
 
     const auto empty_vec  = errors::Error{"no MAC address provided"};
@@ -292,6 +757,128 @@ TEST_CASE("ConnR::find_by_addr") {
     }
 }
 
+// Ensures that the single-statement batch search returns the same results
+// as the regular search.
+TEST_CASE("ConnR::find_by_addr_batch") {
+    const ConnR conn{"testdata/sample.db", true};
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"00:00:0C"},
+        {"00:00:0C:12:34:56"},
+        {"00000c"},
+        {"00:00:aa:12:34:56"},
+        {"00:00:0C", "00:00:0C"},
+        {"00:00:0C", "00:00:AA", "00:48:54"},
+        {"00:00:0C", "12:34:56"},
+        {"012345"},
+        {"000000", "741AE0C", "0050C2003", "024201234567"},
+    };
+
+    for (const auto& input : cases) {
+        CAPTURE(input);
+        REQUIRE(conn.find_by_addr_batch(input) == conn.find_by_addr(input));
+    }
+
+    const auto empty_vec  = errors::Error{"no MAC address provided"};
+    const auto empty_addr = errors::Error{"empty MAC address encountered"};
+    const auto too_short  = errors::Error{"specified MAC address is too short"};
+
+    const std::map<const std::vector<std::string>, const errors::Error&> throw_cases = {
+        {{}, empty_vec},
+        {{"00000C", "", "00:00:AA"}, empty_addr},
+        {{"0000c"}, too_short},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            conn.find_by_addr_batch(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
+// Ensures that find_best_by_addr reports the most specific block for every
+// address, including addresses that fall between sibling blocks.
+TEST_CASE("ConnR::find_best_by_addr") {
+    const std::string db_path = "file:connr_find_best_by_addr?mode=memory&cache=shared";
+
+    ConnRW conn_rw{db_path, true};
+
+    std::ifstream      nested{"testdata/nested.csv"};
+    std::ostringstream warnings;
+
+    REQUIRE_NOTHROW(conn_rw.insert(nested, true, warnings));
+
+    const ConnR conn{db_path, true};
+
+    const std::map<const std::string, const std::optional<std::string>> cases = {
+        {"5CF286D12345", "5C:F2:86:D"},
+        {"5C:F2:86:E0:00:00", "5C:F2:86"}, // 5C:F2:86:D lies between the address and its MA-L
+        {"5CF2864", "5C:F2:86:4"},
+        {"5CF286", "5C:F2:86"},
+        {"8C1F64FFC123", "8C:1F:64:FF:C"},
+        {"8C1F64FFD", "8C:1F:64"},
+        {"8C1F64F5A", "8C:1F:64:F5:A"},
+        {"8C1F64F5", "8C:1F:64"}, // Too short for MA-S
+        {"024201234567", "02:42:00"},
+        {"000000", std::nullopt},
+        {"FFFFFF", std::nullopt},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input);
+
+        const auto results = conn.find_best_by_addr({&input, 1});
+        REQUIRE(results.size() == 1);
+
+        if (expected) {
+            REQUIRE(results[0].has_value());
+            REQUIRE(prefix_to_string(results[0]->mac_prefix, results[0]->prefix_len) == *expected);
+        } else {
+            REQUIRE(!results[0].has_value());
+        }
+
+        // The most specific block is the greatest of all matching ones,
+        // except Docker's, which is a fallback for 02:42 addresses.
+        const VendorList all = conn.find_by_addr({&input, 1});
+
+        if (all.size() != 0 && input != "024201234567") {
+            REQUIRE(results[0] == all[all.size() - 1]);
+        }
+    }
+
+    const std::vector<std::string> inputs = {"5CF286D12345", "000000", "5CF286D12345"};
+
+    const auto results = conn.find_best_by_addr(inputs);
+
+    REQUIRE(results.size() == inputs.size());
+    REQUIRE(results[0] == results[2]);
+    REQUIRE(!results[1].has_value());
+
+    const auto empty_vec  = errors::Error{"no MAC address provided"};
+    const auto empty_addr = errors::Error{"empty MAC address encountered"};
+    const auto too_short  = errors::Error{"specified MAC address is too short"};
+
+    const std::map<const std::vector<std::string>, const errors::Error&> throw_cases = {
+        {{}, empty_vec},
+        {{"5CF286", "", "8C1F64"}, empty_addr},
+        {{"5cf28"}, too_short},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            conn.find_best_by_addr(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
 TEST_CASE("ConnR::find_by_name") {
     const ConnR conn{"testdata/sample.db", true};
 
@@ -313,19 +900,40 @@ TEST_CASE("ConnR::find_by_name") {
         {{"xerox", "unknown"}, {xerox}},
         {{"cisco", "cisco"}, {cisco}}, // Duplicate search terms
         {{"non-existent"}, {}},        // Valid, not found
+        {{"c_sco"}, {cisco}},          // Wildcards around an indexed run
+        {{"sco%tems"}, {cisco}},
+        {{"sco%xerox"}, {}},
+        {{"x%n"}, {xerox}},            // No indexed run, scanned
+        {{"%"}, {cisco, xerox}},
+        {{R"(ems\, in)"}, {cisco}},    // Escaped literal
+        {{R"(inc\)"}, {}},             // Trailing escape character
     };
 
     for (const auto& [input, expected] : cases) {
         CAPTURE(input.size());
         CAPTURE(expected.size());
 
-        std::set<Vendor> results = conn.find_by_name(input);
+        VendorList results = conn.find_by_name(input);
 
         CAPTURE(results.size());
 
-        REQUIRE(results == expected);
+        REQUIRE(std::ranges::equal(results, expected));
     }
 
+    // Long lists are matched in a single pass and return the same results
+    std::vector<std::string> many(NameMatcher::MIN_TERMS, "non-existent");
+    many.push_back("c_sco");
+    many.push_back("corp");
+
+    REQUIRE(std::ranges::equal(conn.find_by_name(many), std::set<Vendor>{cisco, xerox}));
+
+    many.push_back("");
+    REQUIRE_THROWS_MATCHES(
+        conn.find_by_name(many),
+        errors::Error,
+        Catch::Matchers::Message("empty vendor name encountered")
+    );
+
     const std::map<const std::vector<std::string>, const errors::Error> throw_cases = {
         {{}, errors::Error{"no vendor names provided"}},
         {{""}, errors::Error{"empty vendor name encountered"}},
@@ -343,6 +951,214 @@ TEST_CASE("ConnR::find_by_name") {
     }
 }
 
+TEST_CASE("ConnR::find_by_name_grouped") {
+    const ConnR conn{"testdata/sample.db", true};
+
+    const Vendor cisco{0x00000C, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17"};
+    const Vendor xerox{0x0000AA, "XEROX CORPORATION", false, Registry::MA_L, "2015/11/17"};
+
+    // <input, expected records matched by each term>
+    const std::map<std::vector<std::string>, std::vector<std::set<Vendor>>> cases = {
+        {{"cisco"}, {{cisco}}},
+        {{"cisco", "xerox"}, {{cisco}, {xerox}}},
+        {{"xerox", "unknown"}, {{xerox}, {}}},
+        {{"cisco", "cisco"}, {{cisco}, {cisco}}}, // Duplicate search terms
+        {{"c_sco", "x%n"}, {{cisco}, {xerox}}},   // Indexed and scanned
+        {{"%", "systems"}, {{cisco, xerox}, {cisco}}},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input);
+
+        const auto groups = conn.find_by_name_grouped(input);
+
+        REQUIRE(groups.size() == expected.size());
+
+        for (size_t i = 0; i < groups.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(std::ranges::equal(groups[i], expected[i]));
+        }
+    }
+
+    // Terms of long lists are tagged in a single pass
+    std::vector<std::string> many(NameMatcher::MIN_TERMS, "non-existent");
+    many.push_back("c_sco");
+    many.push_back("corp");
+    many.push_back("o");
+
+    const auto groups = conn.find_by_name_grouped(many);
+
+    REQUIRE(groups.size() == many.size());
+
+    for (size_t i = 0; i < NameMatcher::MIN_TERMS; i++) {
+        REQUIRE(groups[i].size() == 0);
+    }
+
+    REQUIRE(std::ranges::equal(groups[NameMatcher::MIN_TERMS], std::set<Vendor>{cisco}));
+    REQUIRE(std::ranges::equal(groups[NameMatcher::MIN_TERMS + 1], std::set<Vendor>{xerox}));
+    REQUIRE(std::ranges::equal(groups[NameMatcher::MIN_TERMS + 2], std::set<Vendor>{cisco, xerox}));
+
+    REQUIRE_THROWS_MATCHES(
+        conn.find_by_name_grouped(std::vector<std::string>{}),
+        errors::Error,
+        Catch::Matchers::Message("no vendor names provided")
+    );
+    REQUIRE_THROWS_MATCHES(
+        conn.find_by_name_grouped(std::vector<std::string>{"cisco", ""}),
+        errors::Error,
+        Catch::Matchers::Message("empty vendor name encountered")
+    );
+}
+
+TEST_CASE("ConnR::find_exact, ConnR::find_prefix") {
+    const ConnR conn{"testdata/sample.db", true};
+
+    const Vendor cisco{0x00000C, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17"};
+    const Vendor xerox{0x0000AA, "XEROX CORPORATION", false, Registry::MA_L, "2015/11/17"};
+
+    // <input, expected>
+    const std::map<std::vector<std::string>, std::set<Vendor>> exact_cases = {
+        {{"Cisco Systems, Inc"}, {cisco}},
+        {{"cisco systems"}, {cisco}},
+        {{"CISCO-SYSTEMS Inc."}, {cisco}},
+        {{"xerox"}, {xerox}},
+        {{"Xerox Corp."}, {xerox}},
+        {{"cisco", "xerox"}, {xerox}}, // Whole names only
+        {{"xerox", "xerox corporation"}, {xerox}},
+        {{"cisco sys"}, {}},
+        {{"%"}, {}},                   // No letters or digits
+        {{"non-existent"}, {}},
+    };
+
+    for (const auto& [input, expected] : exact_cases) {
+        CAPTURE(input);
+
+        VendorList results = conn.find_exact(input);
+
+        CAPTURE(results.size());
+
+        REQUIRE(std::ranges::equal(results, expected));
+    }
+
+    // <input, expected>
+    const std::map<std::vector<std::string>, std::set<Vendor>> prefix_cases = {
+        {{"cisco"}, {cisco}},
+        {{"Cisco Sys"}, {cisco}},
+        {{"cisco systems, inc"}, {cisco}},
+        {{"c"}, {cisco}},
+        {{"x", "cis"}, {cisco, xerox}},
+        {{"systems"}, {}}, // Not a leading word
+        {{"xerox corporation international"}, {}},
+        {{"%"}, {}},
+    };
+
+    for (const auto& [input, expected] : prefix_cases) {
+        CAPTURE(input);
+
+        VendorList results = conn.find_prefix(input);
+
+        CAPTURE(results.size());
+
+        REQUIRE(std::ranges::equal(results, expected));
+    }
+
+    const std::map<const std::vector<std::string>, const errors::Error> throw_cases = {
+        {{}, errors::Error{"no vendor names provided"}},
+        {{"cisco", "", "xerox"}, errors::Error{"empty vendor name encountered"}},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            conn.find_exact(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+
+        REQUIRE_THROWS_MATCHES(
+            conn.find_prefix(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
+TEST_CASE("ConnR::find_fuzzy") {
+    const ConnR conn{"testdata/sample.db", true};
+
+    const Vendor cisco{0x00000C, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17"};
+    const Vendor xerox{0x0000AA, "XEROX CORPORATION", false, Registry::MA_L, "2015/11/17"};
+
+    // <input, expected>, results are ordered by the search terms
+    const std::map<std::vector<std::string>, std::vector<Vendor>> cases = {
+        {{"cisco sytems"}, {cisco}},
+        {{"CISCO SYSTEMS INC"}, {cisco}},
+        {{"xerox corporaton", "cisco"}, {xerox, cisco}},
+        {{"cisco", "xerox", "cisco sytems"}, {cisco, xerox}}, // Repeated matches
+        {{"xrx"}, {}},                                       // Too short for an edit
+        {{"non-existent"}, {}},
+        {{"%"}, {}},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input);
+
+        VendorList results = conn.find_fuzzy(input, 5);
+
+        CAPTURE(results.size());
+
+        REQUIRE(std::ranges::equal(results, expected));
+    }
+
+    const std::map<const std::vector<std::string>, const errors::Error> throw_cases = {
+        {{}, errors::Error{"no vendor names provided"}},
+        {{"cisco", "", "xerox"}, errors::Error{"empty vendor name encountered"}},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            conn.find_fuzzy(input, 5),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+
+    REQUIRE_THROWS_MATCHES(
+        conn.find_fuzzy(std::vector<std::string>{"cisco"}, 0),
+        errors::Error,
+        Catch::Matchers::Message("number of results must be positive")
+    );
+
+    SECTION("index rebuilt after a change") {
+        const std::string db_path = "testdata/fuzzy.db";
+
+        std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+        const ConnR conn_r{db_path, true};
+
+        const std::vector<std::string> input = {"acme netwrks"};
+
+        REQUIRE(conn_r.find_fuzzy(input, 5).size() == 0);
+        REQUIRE(conn_r.find_fuzzy(input, 5).size() == 0);
+
+        {
+            ConnRW conn_rw{db_path, true};
+
+            std::stringstream ss;
+            ss << "Header\n00:AB:CD,Acme Networks,false,MA-L,2015/11/17\n";
+
+            REQUIRE_NOTHROW(conn_rw.insert(ss, false));
+        }
+
+        const VendorList results = conn_r.find_fuzzy(input, 5);
+
+        REQUIRE(std::ranges::equal(results, std::vector<Vendor>{{0x00ABCD, "Acme Networks", false, Registry::MA_L, "2015/11/17"}}));
+    }
+}
+
 TEST_CASE("user_version") {
     const std::string path = "file:memdb_user_version?mode=memory&cache=shared";
 
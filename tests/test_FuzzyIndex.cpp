@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "FuzzyIndex.hpp"
+
+TEST_CASE("FuzzyIndex::normalize") {
+    // <input, expected>
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"Cisco Systems, Inc", "cisco systems inc"},
+        {"  Hewlett-Packard  Co. ", "hewlett packard co"},
+        {"QEMU/KVM", "qemu kvm"},
+        {"3Com Europe Ltd", "3com europe ltd"},
+        {"Zażółć", "zażółć"},
+        {"", ""},
+        {"., -", ""},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input);
+        REQUIRE(FuzzyIndex::normalize(input) == expected);
+    }
+}
+
+// Ensures that misspelled names are found and ranked by edit distance,
+// then by trigram similarity.
+TEST_CASE("FuzzyIndex::find") {
+    const std::vector<std::string> vendors = {
+        "Cisco Systems, Inc",
+        "Cisco-Linksys, LLC",
+        "Hewlett Packard Enterprise",
+        "Hewlett Packard",
+        "XEROX CORPORATION",
+        "Systech Corporation",
+        "Zażółć Gęślą",
+        "Guangdong Oppo Mobile Telecommunications Corp., Ltd. Shenzhen Branch",
+    };
+
+    std::string                   strings;
+    std::vector<FuzzyIndex::Name> names;
+
+    for (const auto& v : vendors) {
+        names.push_back({static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(v.size()), 0});
+        strings += v;
+    }
+
+    const FuzzyIndex::Tables tables = FuzzyIndex::build(strings, names);
+    const FuzzyIndex         index{strings, tables};
+
+    // <<term, top>, expected>
+    const std::vector<std::pair<std::pair<std::string, size_t>, std::vector<uint32_t>>> cases = {
+        {{"cisco sytems", 5}, {0}},
+        {{"CISCO", 5}, {0, 1}},
+        {{"cisco", 1}, {0}},
+        {{"hewlet packard", 5}, {3, 2}},
+        {{"hewlet packard", 1}, {3}},
+        {{"hewlet pakard", 1}, {3}}, // Edits in distinct pieces of the term
+        {{"packard enterprize", 5}, {2}},
+        {{"xerox corp", 5}, {4}},
+        {{"corporaton", 5}, {4, 5}},
+        {{"zazolc", 5}, {}}, // Non-ASCII letters are compared byte by byte
+        {{"żółć", 5}, {6}},
+        {{"guangdong opo mobile telecommunications corp ltd shenzhen branch", 5}, {7}}, // Over 64 characters
+        {{"non-existent", 5}, {}},
+        {{"., -", 5}, {}},
+        {{"cisco", 0}, {}},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input.first, input.second);
+        REQUIRE(index.find(input.first, input.second) == expected);
+    }
+}
@@ -0,0 +1,184 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_exception.hpp>
+
+#include <map>
+#include <sstream>
+
+#include "cache/ConnR.hpp"
+#include "cache/ConnRW.hpp"
+#include "cache/Index.hpp"
+#include "exception.hpp"
+#include "utils.hpp"
+
+// Ensures that the in-memory index returns exactly the same results
+// as the SQLite-backed search.
+TEST_CASE("Index::find_by_addr") {
+    const ConnR conn{"testdata/sample.db", true};
+    const Index index{conn};
+
+    REQUIRE(index.size() == 3);
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"00:00:0C"},
+        {"00:00:0C:12:34:56"},
+        {"00000C123"},
+        {"00000c"},
+        {"00:00:aa:12:34:56"},
+        {"00:00:0C", "00:00:0C"},
+        {"00:00:0C", "00:00:AA", "00:48:54"},
+        {"00:00:0C", "12:34:56"},
+        {"012345"},
+        {"000000", "741AE0C", "0050C2003", "024201234567"},
+    };
+
+    for (const auto& input : cases) {
+        CAPTURE(input);
+
+        const VendorList expected = conn.find_by_addr(input);
+        const VendorList results  = index.find_by_addr(input);
+
+        REQUIRE(results == expected);
+    }
+
+    const auto empty_vec  = errors::Error{"no MAC address provided"};
+    const auto empty_addr = errors::Error{"empty MAC address encountered"};
+    const auto too_short  = errors::Error{"specified MAC address is too short"};
+    const auto invalid    = errors::Error{"specified MAC address contains invalid characters"};
+
+    const std::map<const std::vector<std::string>, const errors::Error&> throw_cases = {
+        {{}, empty_vec},
+        {{""}, empty_addr},
+        {{"00000C", "", "00:00:AA"}, empty_addr},
+        {{"0000c"}, too_short},
+        {{"::::::::::::"}, empty_addr},
+        {{"01234x"}, invalid},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            index.find_by_addr(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
+// Exercises the Eytzinger search on buckets large enough to form
+// a multi-level tree, including keys absent from the index.
+TEST_CASE("Index: bucket search") {
+    const std::string db_path = "file:memdb_index_search?mode=memory&cache=shared";
+
+    ConnRW conn_rw{db_path, true};
+
+    std::stringstream ss;
+    ss << "Header\n";
+
+    // Every third MA-L block in the range is present
+    for (int64_t p = 0; p < 3000; p += 3) {
+        ss << prefix_to_string(p) << ",Vendor " << p << ",false,MA-L,2015/11/17\n";
+    }
+
+    REQUIRE_NOTHROW(conn_rw.insert(ss, false));
+
+    const ConnR conn{db_path, true};
+    const Index index{conn};
+
+    REQUIRE(index.size() == 1000);
+
+    for (int64_t p = 0; p < 3003; p++) {
+        const std::string addr = prefix_to_string(p);
+        CAPTURE(addr);
+
+        const VendorList results = index.find_by_addr({&addr, 1});
+
+        REQUIRE(results.size() == (p < 3000 && p % 3 == 0 ? 1 : 0));
+    }
+}
+
+// Ensures that in-memory name searches return exactly the same results
+// as the SQLite-backed search.
+TEST_CASE("Index::find_by_name") {
+    const ConnR conn{"testdata/sample.db", true};
+    const Index index{conn};
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"Cisco Systems, Inc"},
+        {"cisco sys"},
+        {"CiScO SYS"},
+        {"cisco", "xerox"},
+        {"xerox", "unknown"},
+        {"non-existent"},
+        {"%"},
+        {"_"},
+        {"c_sco"},
+        {"x%n"},
+        {"\\%"},
+        {"inc\\"},
+        {"c"},
+        {"inc"},
+    };
+
+    for (const auto& input : cases) {
+        CAPTURE(input);
+        REQUIRE(index.find_by_name(input) == conn.find_by_name(input));
+    }
+
+    const std::map<const std::vector<std::string>, const errors::Error> throw_cases = {
+        {{}, errors::Error{"no vendor names provided"}},
+        {{"cisco", "", "xerox"}, errors::Error{"empty vendor name encountered"}},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            index.find_by_name(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
+// Exercises the vectorized scan across chunks searched by separate threads,
+// including matches at the edges of names and chunks.
+TEST_CASE("Index: name scan") {
+    const std::string db_path = "file:memdb_index_names?mode=memory&cache=shared";
+
+    ConnRW conn_rw{db_path, true};
+
+    std::stringstream ss;
+    ss << "Header\n";
+
+    for (int64_t p = 0; p < 10'000; p++) {
+        ss << prefix_to_string(p) << ",Vendor " << p << " Networks " << (p % 7 == 0 ? "GmbH" : "Inc") << ",false,MA-L,2015/11/17\n";
+    }
+
+    REQUIRE_NOTHROW(conn_rw.insert(ss, false));
+
+    const ConnR conn{db_path, true};
+    const Index index{conn, 4};
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"vendor 1"},
+        {"VENDOR 9999 "},
+        {"gmbh"},
+        {"v"},
+        {"h"},
+        {"0 net"},
+        {"vendor 12%gmbh"},
+        {"vendor _3 "},
+        {"inc", "gmbh"},
+        {"non-existent"},
+        {"vendor 1", "vendor 2", "vendor 3", "vendor 4", "vendor 5", "vendor 6", "vendor 7", "vendor 8",
+         "vendor 9", "0 net", "1 net", "2 net", "vendor 12%gmbh", "vendor _3 ", "gmbh", "non-existent",
+         "vendor 10", "vendor 20", "vendor 30", "vendor 40", "vendor 50", "vendor 60", "vendor 70", "vendor 80",
+         "vendor 90", "3 net", "4 net", "5 net", "6 net", "7 net", "8 net", "9 net"},
+    };
+
+    for (const auto& input : cases) {
+        CAPTURE(input);
+        REQUIRE(index.find_by_name(input) == conn.find_by_name(input));
+    }
+}
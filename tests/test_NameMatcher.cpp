@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "NameMatcher.hpp"
+
+// Ensures that every term occurring in a name is reported, including
+// terms that overlap or are contained in one another.
+TEST_CASE("NameMatcher: match") {
+    const std::vector<std::string> terms = {
+        "he",       // 0
+        "she",      // 1
+        "his",      // 2
+        "hers",     // 3
+        "HERS",     // 4, duplicate after folding
+        "c_sco",    // 5, wildcard
+        "x%n",      // 6, wildcard
+        "ółć",      // 7, non-ASCII
+        R"(100\%)", // 8, escaped wildcard
+    };
+
+    const NameMatcher matcher{terms};
+
+    // <name, expected>
+    const std::vector<std::pair<std::string, std::vector<uint32_t>>> cases = {
+        {"ushers", {0, 1, 3, 4}},
+        {"USHERS", {0, 1, 3, 4}},
+        {"this", {2}},
+        {"h", {}},
+        {"", {}},
+        {"Cisco Systems, Inc", {5}},
+        {"XEROX CORPORATION", {6}},
+        {"Zażółć", {7}},
+        {"ZAŻÓŁĆ", {}}, // Non-ASCII letters are case-sensitive
+        {"100% hers", {0, 3, 4, 8}},
+        {"1000", {}},
+    };
+
+    for (const auto& [name, expected] : cases) {
+        CAPTURE(name);
+        REQUIRE(matcher.match(name) == expected);
+        REQUIRE(matcher.matches(name) == !expected.empty());
+    }
+}
+
+// Ensures that failure links lead the automaton back to shorter terms
+// after a mismatch in a long one.
+TEST_CASE("NameMatcher: failure links") {
+    const std::vector<std::string> terms = {"abcd", "bce", "cf"};
+
+    const NameMatcher matcher{terms};
+
+    // <name, expected>
+    const std::vector<std::pair<std::string, std::vector<uint32_t>>> cases = {
+        {"abcd", {0}},
+        {"abce", {1}},
+        {"abcf", {2}},
+        {"ababcd", {0}},
+        {"abcbce", {1}},
+        {"abc", {}},
+    };
+
+    for (const auto& [name, expected] : cases) {
+        CAPTURE(name);
+        REQUIRE(matcher.match(name) == expected);
+    }
+}
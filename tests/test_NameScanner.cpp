@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NameScanner.hpp"
+#include "utils.hpp"
+
+// Returns the positions of the names matching any of the terms,
+// found by matching every name against every term.
+static std::vector<uint32_t> brute_force(const std::vector<std::string_view>& names, const std::vector<std::string>& terms) {
+    std::vector<uint32_t> found;
+
+    for (size_t i = 0; i < names.size(); i++) {
+        for (const auto& t : terms) {
+            if (!names[i].empty() && like_match(names[i], '%' + t + '%')) {
+                found.push_back(static_cast<uint32_t>(i));
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+// Returns the positions of the names matching each of the terms,
+// by term position.
+static std::vector<std::vector<uint32_t>> brute_force_each(const std::vector<std::string_view>& names, const std::vector<std::string>& terms) {
+    std::vector<std::vector<uint32_t>> found;
+
+    for (const auto& t : terms) {
+        found.push_back(brute_force(names, {t}));
+    }
+
+    return found;
+}
+
+// Ensures that the scan agrees with LIKE for plain terms, wildcards,
+// escapes and terms without a literal run, including matches at the edges
+// of names.
+TEST_CASE("NameScanner::find") {
+    const std::vector<std::string_view> names = {
+        "Cisco Systems, Inc",
+        "XEROX CORPORATION",
+        "",
+        "c",
+        "100% Networks",
+        "Inc\\",
+        "Zażółć",
+        "systems",
+    };
+
+    const NameScanner scanner{names};
+
+    REQUIRE(scanner.size() == names.size());
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"cisco"},
+        {"SYSTEMS"},
+        {"c"},
+        {"%"},
+        {"_"},
+        {"c_sco"},
+        {"x%n"},
+        {"\\%"},
+        {"inc\\"},
+        {"ółć"},
+        {"ÓŁĆ"},
+        {"non-existent"},
+        {"cisco", "xerox", "systems"},
+        {"systems", "c", "systems"},
+    };
+
+    for (const auto& terms : cases) {
+        CAPTURE(terms);
+        REQUIRE(scanner.find(terms) == brute_force(names, terms));
+        REQUIRE(scanner.find_each(terms) == brute_force_each(names, terms));
+    }
+}
+
+// Exercises chunks scanned by separate threads and the single pass
+// used for long lists of terms.
+TEST_CASE("NameScanner: chunks") {
+    std::vector<std::string> stored;
+    for (int p = 0; p < 20'000; p++) {
+        stored.push_back("Vendor " + std::to_string(p) + " Networks " + (p % 7 == 0 ? "GmbH" : "Inc"));
+    }
+
+    const std::vector<std::string_view> names{stored.begin(), stored.end()};
+
+    const NameScanner scanner{names, 4};
+
+    std::vector<std::string> many;
+    for (size_t i = 0; i < NameScanner::MIN_MATCHER_TERMS; i++) {
+        many.push_back("vendor " + std::to_string(i * 37) + " ");
+    }
+
+    const std::vector<std::vector<std::string>> cases = {
+        {"vendor 1"},
+        {"VENDOR 19999 "},
+        {"gmbh"},
+        {"v"},
+        {"vendor 12%gmbh"},
+        {"vendor _3 "},
+        many,
+    };
+
+    for (const auto& terms : cases) {
+        CAPTURE(terms);
+        REQUIRE(scanner.find(terms) == brute_force(names, terms));
+        REQUIRE(scanner.find_each(terms) == brute_force_each(names, terms));
+    }
+
+    // Terms of a long list are told apart by the single pass
+    many.push_back("gmbh");
+    many.push_back("vendor 1%inc");
+
+    REQUIRE(scanner.find_each(many) == brute_force_each(names, many));
+}
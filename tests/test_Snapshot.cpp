@@ -0,0 +1,290 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_exception.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <sqlite3.h>
+
+#include "cache/ConnR.hpp"
+#include "cache/ConnRW.hpp"
+#include "cache/Snapshot.hpp"
+#include "exception.hpp"
+
+// Ensures that the snapshot returns exactly the same results
+// as the database it was generated from.
+TEST_CASE("Snapshot: lookups") {
+    const std::string db_path   = "testdata/snapshot.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    const ConnR conn{db_path, true};
+
+    REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, conn.export_records()));
+
+    const Snapshot snap{snap_path, db_path};
+
+    REQUIRE(snap.export_records() == conn.export_records());
+
+    const std::vector<std::vector<std::string>> addr_cases = {
+        {"00:00:0C"},
+        {"00:00:0C:12:34:56"},
+        {"00000c"},
+        {"00:00:aa:12:34:56"},
+        {"00:00:0C", "00:00:AA", "00:48:54"},
+        {"012345"},
+        {"000000", "741AE0C", "0050C2003", "024201234567"},
+    };
+
+    for (const auto& input : addr_cases) {
+        CAPTURE(input);
+        REQUIRE(snap.find_by_addr(input) == conn.find_by_addr(input));
+    }
+
+    const std::vector<std::vector<std::string>> name_cases = {
+        {"Cisco Systems, Inc"},
+        {"cisco sys"},
+        {"CiScO SYS"},
+        {"cisco", "xerox"},
+        {"xerox", "unknown"},
+        {"non-existent"},
+        {"%"},
+        {"_"},
+        {"c_sco"},
+        {"x%n"},
+        {"\\%"},
+        {"inc\\"},
+    };
+
+    for (const auto& input : name_cases) {
+        CAPTURE(input);
+        REQUIRE(snap.find_by_name(input) == conn.find_by_name(input));
+        REQUIRE(snap.find_by_name_grouped(input) == conn.find_by_name_grouped(input));
+    }
+
+    const std::vector<std::vector<std::string>> norm_cases = {
+        {"Cisco Systems, Inc"},
+        {"cisco systems"},
+        {"Xerox Corp."},
+        {"cisco", "xerox"},
+        {"c"},
+        {"x", "cis"},
+        {"systems"},
+        {"%"},
+    };
+
+    for (const auto& input : norm_cases) {
+        CAPTURE(input);
+        REQUIRE(snap.find_exact(input) == conn.find_exact(input));
+        REQUIRE(snap.find_prefix(input) == conn.find_prefix(input));
+    }
+
+    const std::vector<std::vector<std::string>> fuzzy_cases = {
+        {"cisco sytems"},
+        {"xerox corporaton", "cisco"},
+        {"cisco", "xerox", "cisco sytems"},
+        {"non-existent"},
+        {"%"},
+    };
+
+    for (const auto& input : fuzzy_cases) {
+        CAPTURE(input);
+        REQUIRE(snap.find_fuzzy(input, 1) == conn.find_fuzzy(input, 1));
+        REQUIRE(snap.find_fuzzy(input, 5) == conn.find_fuzzy(input, 5));
+    }
+
+    const std::map<const std::vector<std::string>, const errors::Error> throw_cases = {
+        {{}, errors::Error{"no vendor names provided"}},
+        {{"cisco", "", "xerox"}, errors::Error{"empty vendor name encountered"}},
+    };
+
+    for (const auto& [input, expected_error] : throw_cases) {
+        CAPTURE(input);
+
+        REQUIRE_THROWS_MATCHES(
+            snap.find_by_name(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+
+        REQUIRE_THROWS_MATCHES(
+            snap.find_fuzzy(input, 5),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+
+        REQUIRE_THROWS_MATCHES(
+            snap.find_exact(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+
+        REQUIRE_THROWS_MATCHES(
+            snap.find_prefix(input),
+            errors::Error,
+            Catch::Matchers::Message(expected_error.what())
+        );
+    }
+}
+
+// Ensures that the most specific lookup agrees with ConnR on blocks
+// nested inside one another.
+TEST_CASE("Snapshot: find_best_by_addr") {
+    const std::string db_path   = "testdata/snapshot_nested.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::remove(db_path);
+
+    {
+        ConnRW conn_rw{db_path, true};
+
+        std::ifstream      nested{"testdata/nested.csv"};
+        std::ostringstream warnings;
+
+        REQUIRE_NOTHROW(conn_rw.insert(nested, true, warnings));
+    }
+
+    const ConnR conn{db_path, true};
+
+    REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, conn.export_records()));
+
+    const Snapshot snap{snap_path, db_path};
+
+    const std::vector<std::string> inputs = {
+        "5CF286D12345",
+        "5C:F2:86:E0:00:00",
+        "5CF2864",
+        "5CF286",
+        "8C1F64FFC123",
+        "8C1F64FFD",
+        "8C1F64F5A",
+        "8C1F64F5",
+        "024201234567",
+        "000000",
+        "FFFFFF",
+    };
+
+    REQUIRE(snap.find_best_by_addr(inputs) == conn.find_best_by_addr(inputs));
+}
+
+// Ensures that the OUI bitmap resolves blocks placed at the edges
+// of its words and that longer blocks are found only within refined OUIs.
+TEST_CASE("Snapshot: OUI index") {
+    const std::string db_path   = "testdata/snapshot_oui.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    VendorList records;
+
+    records.emplace_back(0x000000, 6, "a", false, Registry::MA_L, "");
+    records.emplace_back(0x00003F, 6, "b", false, Registry::MA_L, "");
+    records.emplace_back(0x000040, 6, "c", false, Registry::MA_L, "");
+    records.emplace_back(0x00007F, 6, "d", false, Registry::MA_L, "");
+    records.emplace_back(0xFFFFFF, 6, "e", false, Registry::MA_L, "");
+    records.emplace_back(0x0000400, 7, "f", false, Registry::MA_M, "");
+    records.emplace_back(0x123456ABC, 9, "g", false, Registry::MA_S, "");
+
+    REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, records));
+
+    const Snapshot snap{snap_path, db_path};
+
+    const std::vector<std::pair<std::string, std::vector<std::string>>> cases = {
+        {"000000", {"a"}},
+        {"00003F", {"b"}},
+        {"000040", {"c"}},
+        {"0000400", {"c", "f"}},
+        {"0000401", {"c"}},
+        {"000041", {}},
+        {"00007F", {"d"}},
+        {"FFFFFF123456", {"e"}},
+        {"123456ABCDEF", {"g"}},
+        {"123456", {}},
+        {"123457ABC", {}},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        CAPTURE(input);
+
+        const auto results = snap.find_by_addr(std::vector{input});
+
+        std::vector<std::string> names;
+        for (const auto& v : results) {
+            names.push_back(v.vendor_name);
+        }
+
+        REQUIRE(names == expected);
+
+        // The most specific block is the last one in key order
+        const auto best = snap.find_best_by_addr(std::vector{input});
+
+        REQUIRE(best.size() == 1);
+        REQUIRE(best[0].has_value() == !expected.empty());
+
+        if (best[0]) {
+            REQUIRE(best[0]->vendor_name == expected.back());
+        }
+    }
+}
+
+TEST_CASE("Snapshot: validation") {
+    const std::string db_path   = "testdata/snapshot_validation.db";
+    const std::string snap_path = Snapshot::path_for(db_path);
+
+    std::filesystem::copy_file("testdata/sample.db", db_path, std::filesystem::copy_options::overwrite_existing);
+
+    // Not a snapshot file
+    REQUIRE_THROWS_AS(Snapshot("testdata/not_cache.txt", db_path), errors::CacheError);
+
+    // Missing file
+    REQUIRE_THROWS_AS(Snapshot("testdata/non-existent.snap", db_path), errors::CacheError);
+
+    {
+        const ConnR conn{db_path, true};
+        REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, conn.export_records()));
+    }
+
+    REQUIRE_NOTHROW(Snapshot(snap_path, db_path));
+
+    // Database modified after the snapshot was written
+    const auto mtime = std::filesystem::last_write_time(db_path);
+    std::filesystem::last_write_time(db_path, mtime + std::chrono::seconds{1});
+
+    REQUIRE_THROWS_AS(Snapshot(snap_path, db_path), errors::CacheError);
+
+    // Database modified without changing its size, within the resolution
+    // of the modification time
+    {
+        const ConnR conn{db_path, true};
+        REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, conn.export_records()));
+    }
+
+    const auto size = std::filesystem::file_size(db_path);
+    const auto written = std::filesystem::last_write_time(db_path);
+    {
+        ConnRW conn{db_path};
+        REQUIRE(sqlite3_exec(conn.get(), "UPDATE vendors SET private = NOT private WHERE prefix = (SELECT min(prefix) FROM vendors)", nullptr, nullptr, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_changes(conn.get()) == 1);
+    }
+    std::filesystem::last_write_time(db_path, written);
+
+    REQUIRE(std::filesystem::file_size(db_path) == size);
+    REQUIRE_THROWS_AS(Snapshot(snap_path, db_path), errors::CacheError);
+
+    // Truncated file
+    {
+        const ConnR conn{db_path, true};
+        REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, conn.export_records()));
+    }
+
+    std::filesystem::resize_file(snap_path, std::filesystem::file_size(snap_path) - 1);
+    REQUIRE_THROWS_AS(Snapshot(snap_path, db_path), errors::CacheError);
+
+    // No records
+    REQUIRE_NOTHROW(Snapshot::write(snap_path, db_path, {}));
+    REQUIRE_THROWS_AS(Snapshot(snap_path, db_path), errors::CacheError);
+}
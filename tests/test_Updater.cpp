@@ -1,14 +1,395 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_exception.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "exception.hpp"
+#include "update/Decompressor.hpp"
+#include "update/Downloader.hpp"
 #include "update/Reader.hpp"
 
+#if !defined(_WIN32)
+// Stand-in for the HTTP server of the data source, listening on a loopback
+// port. Responds with body and its validators, or with 304 Not Modified
+// if the request carries either of them as a conditional header. If set,
+// content_encoding is sent as the encoding of body. If stall_after is less
+// than the size of body, only that many bytes are sent, and the connection
+// is held open until the client closes it. Requests are served one at a time,
+// on a separate thread.
+class HttpStandIn {
+    const std::string body;
+    const std::string etag;
+    const std::string last_modified;
+    const std::string content_encoding;
+    const size_t      stall_after;
+
+    int      listen_fd;
+    uint16_t port;
+
+    std::mutex               mtx;
+    std::vector<std::string> received;
+
+    std::thread thread;
+
+    void serve() {
+        int fd;
+
+        // Fails once the listening socket is shut down
+        while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+            std::string request;
+            char        buf[1024];
+
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    break;
+                }
+                request.append(buf, static_cast<size_t>(n));
+            }
+
+            const bool match = request.find("If-None-Match: " + etag + "\r\n") != std::string::npos ||
+                               request.find("If-Modified-Since: " + last_modified + "\r\n") != std::string::npos;
+
+            std::string response = match ? "HTTP/1.1 304 Not Modified\r\n" : "HTTP/1.1 200 OK\r\n";
+            response += "ETag: " + etag + "\r\n";
+            response += "Last-Modified: " + last_modified + "\r\n";
+            response += "Connection: close\r\n";
+
+            if (!content_encoding.empty()) {
+                response += "Content-Encoding: " + content_encoding + "\r\n";
+            }
+
+            if (match) {
+                response += "\r\n";
+            } else {
+                response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body.substr(0, stall_after);
+            }
+
+            for (size_t sent = 0; sent < response.size();) {
+                const ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                sent += static_cast<size_t>(n);
+            }
+
+            // Waits for the client to give up on the rest of the body
+            if (!match && stall_after < body.size()) {
+                while (recv(fd, buf, sizeof(buf), 0) > 0) {
+                }
+            }
+
+            close(fd);
+
+            const std::lock_guard lock{mtx};
+            received.push_back(std::move(request));
+        }
+    }
+
+public:
+    HttpStandIn(std::string body, std::string etag, std::string last_modified, std::string content_encoding = "", const size_t stall_after = std::string::npos)
+        : body{std::move(body)},
+          etag{std::move(etag)},
+          last_modified{std::move(last_modified)},
+          content_encoding{std::move(content_encoding)},
+          stall_after{stall_after} {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        REQUIRE(listen_fd >= 0);
+
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+
+        socklen_t len = sizeof(addr);
+
+        REQUIRE(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len) == 0);
+        REQUIRE(listen(listen_fd, 4) == 0);
+        REQUIRE(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+
+        port   = ntohs(addr.sin_port);
+        thread = std::thread{[this] { serve(); }};
+    }
+
+    HttpStandIn(const HttpStandIn&)            = delete;
+    HttpStandIn& operator=(const HttpStandIn&) = delete;
+
+    ~HttpStandIn() {
+        shutdown(listen_fd, SHUT_RDWR);
+        thread.join();
+        close(listen_fd);
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port) + "/get-db";
+    }
+
+    // Returns the headers of the requests served so far.
+    std::vector<std::string> requests() {
+        const std::lock_guard lock{mtx};
+        return received;
+    }
+};
+#endif
+
+TEST_CASE("Downloader") {
+    namespace fs = std::filesystem;
+
+    const std::string url = "file://" + fs::absolute("testdata/update.csv").string();
+
+    std::stringstream expected;
+    expected << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+    std::stringstream received;
+
+    Downloader d{url};
+    REQUIRE_NOTHROW(received << d.get().rdbuf());
+    REQUIRE(received.str() == expected.str());
+
+    SECTION("move") {
+        Downloader moved{std::move(d)};
+        REQUIRE(moved.get().get() == std::char_traits<char>::eof());
+    }
+
+    SECTION("transfer error is thrown on read") {
+        Downloader missing{"file://" + fs::absolute("testdata/non-existent.csv").string()};
+
+        std::string line;
+        REQUIRE_THROWS_AS(std::getline(missing.get(), line), errors::UpdateError);
+    }
+
+    SECTION("unread transfer is aborted") {
+        REQUIRE_NOTHROW(Downloader{url});
+    }
+}
+
+#if !defined(_WIN32)
+TEST_CASE("Downloader: conditional request") {
+    const std::string etag          = "\"5d8c72a5edda8d6a\"";
+    const std::string last_modified = "Wed, 21 Oct 2015 07:28:00 GMT";
+
+    std::stringstream body;
+    body << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+    HttpStandIn server{body.str(), etag, last_modified};
+
+    const auto download = [&](const Downloader::Validators& cached) {
+        Downloader d{server.url(), cached};
+
+        std::stringstream received;
+        received << d.get().rdbuf();
+
+        return std::pair{received.str(), d.not_modified()};
+    };
+
+    // Validators of a response are those of the last one
+    Downloader d{server.url()};
+
+    std::stringstream received;
+    REQUIRE_NOTHROW(received << d.get().rdbuf());
+    REQUIRE(received.str() == body.str());
+    REQUIRE_FALSE(d.not_modified());
+    REQUIRE(d.validators().etag == etag);
+    REQUIRE(d.validators().last_modified == last_modified);
+
+    REQUIRE(server.requests().back().find("If-None-Match") == std::string::npos);
+    REQUIRE(server.requests().back().find("If-Modified-Since") == std::string::npos);
+
+    SECTION("unchanged data is not transferred") {
+        const auto [data, not_modified] = download(d.validators());
+        REQUIRE(not_modified);
+        REQUIRE(data.empty());
+
+        const std::string request = server.requests().back();
+        REQUIRE(request.find("If-None-Match: " + etag + "\r\n") != std::string::npos);
+        REQUIRE(request.find("If-Modified-Since: " + last_modified + "\r\n") != std::string::npos);
+
+        // Either validator is enough
+        REQUIRE(download({etag, ""}).second);
+        REQUIRE(download({"", last_modified}).second);
+    }
+
+    SECTION("changed data is transferred") {
+        const auto [data, not_modified] = download({"\"0000000000000000\"", "Tue, 20 Oct 2015 07:28:00 GMT"});
+        REQUIRE_FALSE(not_modified);
+        REQUIRE(data == body.str());
+    }
+}
+
+TEST_CASE("Downloader: content encoding") {
+    std::stringstream expected;
+    expected << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+    std::stringstream compressed;
+    compressed << std::ifstream{"testdata/update.csv.gz", std::ios::binary}.rdbuf();
+
+    HttpStandIn server{compressed.str(), "\"gz\"", "Wed, 21 Oct 2015 07:28:00 GMT", "gzip"};
+
+    Downloader d{server.url()};
+
+    std::stringstream received;
+    REQUIRE_NOTHROW(received << d.get().rdbuf());
+    REQUIRE(received.str() == expected.str());
+
+    const std::string request = server.requests().back();
+    REQUIRE(request.find("Accept-Encoding: ") != std::string::npos);
+    REQUIRE(request.find("gzip", request.find("Accept-Encoding: ")) != std::string::npos);
+}
+#endif
+
+#if !defined(_WIN32)
+// Ensures that a server which stops sending the body fails the transfer
+// instead of blocking the reader, and that an unread stalled transfer
+// is aborted promptly.
+TEST_CASE("Downloader: stalled transfer") {
+    std::stringstream body;
+    body << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+    HttpStandIn server{body.str(), "\"stall\"", "Wed, 21 Oct 2015 07:28:00 GMT", "", body.str().size() / 2};
+
+    SECTION("stall is reported") {
+        Downloader d{server.url(), {}, 1};
+
+        std::string received;
+        REQUIRE_THROWS_AS(received.assign(std::istreambuf_iterator<char>{d.get()}, {}), errors::UpdateError);
+    }
+
+    SECTION("unread transfer is aborted") {
+        const auto start = std::chrono::steady_clock::now();
+
+        {
+            Downloader d{server.url()};
+
+            // Lets the transfer reach the stall
+            std::this_thread::sleep_for(std::chrono::milliseconds{200});
+        }
+
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds{Downloader::STALL_TIMEOUT});
+    }
+}
+#endif
+
+TEST_CASE("Decompressor") {
+    namespace fs = std::filesystem;
+
+    using Format = Decompressor::Format;
+
+    std::stringstream expected;
+    expected << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+    std::stringstream gz;
+    gz << std::ifstream{"testdata/update.csv.gz", std::ios::binary}.rdbuf();
+
+    // Unlike operator<<, the iterator propagates decompression errors
+    const auto decompress = [](const std::string& path) {
+        Decompressor d{Reader{path}};
+        return std::string{std::istreambuf_iterator<char>{d.get()}, {}};
+    };
+
+    const auto write_file = [](const std::string& path, const std::string& data) {
+        std::ofstream{path, std::ios::binary} << data;
+    };
+
+    REQUIRE(Decompressor::detect(Reader{"testdata/update.csv"}.data()) == Format::None);
+    REQUIRE(Decompressor::detect(Reader{"testdata/update.csv.gz"}.data()) == Format::Gzip);
+    REQUIRE(Decompressor::detect(Reader{"testdata/update.csv.zst"}.data()) == Format::Zstd);
+    REQUIRE(Decompressor::detect("") == Format::None);
+
+    REQUIRE(decompress("testdata/update.csv.gz") == expected.str());
+
+    SECTION("moved stream") {
+        Decompressor d{Reader{"testdata/update.csv.gz"}};
+        Decompressor moved{std::move(d)};
+
+        std::string line;
+        REQUIRE(std::getline(moved.get(), line));
+        REQUIRE(line == "Mac Prefix,Vendor Name,Private,Block Type,Last Update");
+    }
+
+    SECTION("concatenated gzip members") {
+        write_file("testdata/concat.csv.gz", gz.str() + gz.str());
+        REQUIRE(decompress("testdata/concat.csv.gz") == expected.str() + expected.str());
+    }
+
+    SECTION("zstd") {
+        if (Decompressor::supports(Format::Zstd)) {
+            REQUIRE(decompress("testdata/update.csv.zst") == expected.str());
+        } else {
+            REQUIRE_THROWS_AS(Decompressor{Reader{"testdata/update.csv.zst"}}, errors::UpdateError);
+        }
+    }
+
+    SECTION("uncompressed file") {
+        REQUIRE_FALSE(Decompressor::supports(Format::None));
+        REQUIRE_THROWS_AS(Decompressor{Reader{"testdata/update.csv"}}, errors::UpdateError);
+    }
+
+    SECTION("truncated data") {
+        write_file("testdata/truncated.csv.gz", gz.str().substr(0, gz.str().size() / 2));
+        REQUIRE_THROWS_AS(decompress("testdata/truncated.csv.gz"), errors::UpdateError);
+    }
+
+    SECTION("corrupted data") {
+        std::string corrupted = gz.str();
+        for (size_t i = 20; i < 40; i++) {
+            corrupted[i] = static_cast<char>(~corrupted[i]);
+        }
+
+        write_file("testdata/corrupted.csv.gz", corrupted);
+        REQUIRE_THROWS_AS(decompress("testdata/corrupted.csv.gz"), errors::UpdateError);
+    }
+
+    SECTION("size limit") {
+        const std::string large_path = "testdata/large.csv.gz";
+
+        if (!fs::exists(large_path)) {
+            gzFile file = gzopen(large_path.c_str(), "wb9");
+            REQUIRE(file);
+
+            const std::string zeros(1 << 20, '\0');
+            for (size_t i = 0; i <= Updater::MAX_FSIZE / zeros.size(); i++) {
+                REQUIRE(gzwrite(file, zeros.data(), static_cast<unsigned>(zeros.size())) == static_cast<int>(zeros.size()));
+            }
+            REQUIRE(gzclose(file) == Z_OK);
+        }
+
+        REQUIRE_THROWS_AS(decompress(large_path), errors::UpdateError);
+    }
+}
+
 TEST_CASE("Reader") {
     REQUIRE_NOTHROW(Reader{"testdata/update.csv"});
 
+    {
+        std::stringstream expected;
+        expected << std::ifstream{"testdata/update.csv"}.rdbuf();
+
+        Reader r{"testdata/update.csv"};
+        REQUIRE(r.data() == expected.str());
+
+        std::string line;
+        REQUIRE(std::getline(r.get(), line));
+        REQUIRE(line == "Mac Prefix,Vendor Name,Private,Block Type,Last Update");
+    }
+
     const std::string bad_path = "testdata/non-existent.csv";
 
     const auto expected_error = errors::Error{"file '" + bad_path + "' not found"};
@@ -1,9 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_exception.hpp>
 
+#include <algorithm>
 #include <map>
 #include <span>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Vendor.hpp"
 #include "cache/ConnR.hpp"
@@ -89,6 +93,7 @@ TEST_CASE("Vendor(string)") {
         {R"(00:00:0D,FIBRONICS LTD.,false)", PrivateTermError{""}},                         // No comma after private field
         {R"(00:00:0D,FIBRONICS LTD.,false,MA-L)", BlockTypeTermError{""}},                  // No comma after block type field
         {R"(5C:F2:86:D,"BrightSky, LLC",,MA-M,2019/07/02)", PrivateInvalidError{""}},       // Private field empty
+        {R"(00:00:0C:00:00:00:0,Vendor,false,MA-L,2015/11/17)", PrefixLengthError{""}},     // Prefix longer than a MAC address
     };
 
     for (const auto& [input, expected_error] : throw_cases) {
@@ -102,6 +107,127 @@ TEST_CASE("Vendor(string)") {
     }
 }
 
+// Ensures that VendorView views the parsed line, unless the vendor name
+// needs unescaping.
+TEST_CASE("VendorView") {
+    std::string buf;
+
+    const std::string_view line = R"(00:00:0C,"Cisco Systems, Inc",false,MA-L,2015/11/17)";
+    const VendorView       v{line, buf};
+
+    REQUIRE(Vendor{v} == Vendor{line});
+    REQUIRE(v.vendor_name.data() == line.data() + 10);
+    REQUIRE(v.last_update.data() == line.data() + line.size() - 10);
+    REQUIRE(buf.empty());
+
+    const std::string_view escaped = R"(2C:7A:FE,"IEE&E ""Black"" ops",false,MA-L,2010/07/26)";
+    const VendorView       e{escaped, buf};
+
+    REQUIRE(e.vendor_name == "IEE&E \"Black\" ops");
+    REQUIRE(e.vendor_name.data() == buf.data());
+    REQUIRE(e.key() == Vendor{escaped}.key());
+}
+
+TEST_CASE("VendorBlock") {
+    const std::string csv = "00:00:0C,\"Cisco Systems, Inc\",false,MA-L,2015/11/17\n"
+                            "\n"
+                            "2C:7A:FE,\"IEE&E \"\"Black\"\" ops\",false,MA-L,2010/07/26\n"
+                            "2C:7A:FF,\"\"\"Quoted\"\"\",false,MA-L,2010/07/26\n"
+                            "00:48:54,,true,,0001/01/01";
+
+    VendorBlock parsed{csv};
+
+    // Unescaped names stay valid when the block is moved
+    const VendorBlock block{std::move(parsed)};
+
+    const std::vector<Vendor> expected = {
+        Vendor{0x00000C, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17"},
+        Vendor{0x2C7AFE, "IEE&E \"Black\" ops", false, Registry::MA_L, "2010/07/26"},
+        Vendor{0x2C7AFF, "\"Quoted\"", false, Registry::MA_L, "2010/07/26"},
+        Vendor{0x004854, "", true, Registry::Unknown, ""},
+    };
+
+    REQUIRE(block.rows.size() == expected.size());
+    REQUIRE(block.unescaped.size() == 2);
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        REQUIRE(Vendor{block.rows[i]} == expected[i]);
+    }
+
+    REQUIRE_THROWS_AS(VendorBlock{csv + "\n00:00:0D,FIBRONICS LTD."}, errors::UnquotedTermError);
+}
+
+// Compares the records and errors of VendorBlock with VendorView for lines
+// derived from valid ones by replacing, inserting and removing characters
+// that the parsers look for. Lines are surrounded by others, so that
+// all of them are reached by the vectorized search.
+TEST_CASE("VendorBlock: consistency with VendorView") {
+    const std::vector<std::string> valid = {
+        R"(00:00:0C,"Cisco Systems, Inc",false,MA-L,2015/11/17)",
+        R"(00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17)",
+        R"(2C:7A:FE,"IEE&E ""Black"" ops",false,MA-L,2010/07/26)",
+        R"(8C:1F:64:F5:A,Telco Antennas Pty Ltd,false,MA-S,2021/10/13)",
+        R"(00:48:54,,true,,0001/01/01)",
+        R"(00:48:54,non-empty,true,,0001/01/01)",
+    };
+
+    const std::string_view special = ",\"tf:x\r";
+
+    // Outcome of parsing line: the record, or the error message
+    const auto parse = [](const auto& make) -> std::string {
+        try {
+            std::ostringstream os;
+            os << out::csv << make();
+            return os.str();
+        } catch (const errors::Error& e) {
+            return std::string{"error: "} + e.what();
+        }
+    };
+
+    const std::string filler = R"(00:00:0D,FIBRONICS LTD.,false,MA-L,2015/11/17)";
+
+    uint32_t seed = 1;
+    const auto next = [&] {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7FFF;
+    };
+
+    for (int n = 0; n < 20000; n++) {
+        std::string line = valid[next() % valid.size()];
+
+        for (uint32_t k = next() % 3 + 1; k > 0; k--) {
+            const size_t pos = next() % (line.size() + 1);
+            const char   c   = special[next() % special.size()];
+
+            switch (next() % 3) {
+            case 0: line.insert(pos, 1, c); break;
+            case 1: line.erase(std::min(pos, line.size() - 1), 1); break;
+            default:
+                if (pos < line.size()) {
+                    line[pos] = c;
+                }
+            }
+        }
+
+        CAPTURE(line);
+
+        std::string buf;
+
+        const std::string expected = parse([&] { return Vendor{VendorView{line, buf}}; });
+
+        // <block, row of line in the block>
+        const std::pair<std::string, size_t> blocks[] = {
+            {line, 0},
+            {filler + '\n' + line, 1},
+            {filler + '\n' + filler + '\n' + line + '\n' + filler, 2},
+        };
+
+        for (const auto& [block, row] : blocks) {
+            REQUIRE(parse([&] { return Vendor{VendorBlock{block}.rows.at(row)}; }) == expected);
+        }
+    }
+}
+
 // Ensures that a NULL text value returned from the database
 // is correctly handled. Although the vendors table does not
 // allow NULL text values, the check was implemented
@@ -111,10 +237,10 @@ TEST_CASE("NULL values") {
 
     const std::string search_term = "00:00:0C";
 
-    std::set<Vendor> results = conn_r2.find_by_addr({&search_term, 1});
+    VendorList results = conn_r2.find_by_addr({&search_term, 1});
 
-    REQUIRE(!results.empty());
-    REQUIRE(results.begin()->vendor_name == "");
+    REQUIRE(results.size() != 0);
+    REQUIRE(results[0].vendor_name == "");
 }
 
 TEST_CASE("operator<< out::csv") {
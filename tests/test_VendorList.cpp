@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "VendorList.hpp"
+
+// Ensures that records are restored verbatim, regardless of whether
+// their update dates can be packed.
+TEST_CASE("VendorList: round trip") {
+    const std::vector<Vendor> cases = {
+        {0x00000C, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17"},
+        {0x5CF286D, "BrightSky, LLC", false, Registry::MA_M, "2019/07/02"},
+        {0x8C1F64FFC, "Invendis Technologies India Pvt Ltd", false, Registry::MA_S, "2022/07/19"},
+        {0x004854, "", true, Registry::Unknown, ""},
+        {0x000000, "", true, Registry::Unknown, "0001/01/01"},
+        {0x000001, "Vendor", false, Registry::CID, "2015/13/01"},  // Invalid month
+        {0x000002, "Vendor", false, Registry::IAB, "2015/00/01"},  // Invalid month
+        {0x000003, "Vendor", false, Registry::MA_L, "2015/01/32"}, // Invalid day
+        {0x000004, "Vendor", false, Registry::MA_L, "2015-01-01"}, // Different separators
+        {0x000005, "Vendor", false, Registry::MA_L, "15/01/01"},
+        {0x000006, "Vendor", false, Registry::MA_L, "unknown"},
+        {0x000007, "Vendor", false, Registry::MA_L, "0000/00/00"},
+    };
+
+    VendorList list;
+
+    for (const auto& v : cases) {
+        list.push_back(v);
+    }
+
+    REQUIRE(list.size() == cases.size());
+    REQUIRE(std::ranges::equal(list, cases));
+
+    for (size_t i = 0; i < cases.size(); i++) {
+        CAPTURE(i);
+        REQUIRE(list[i] == cases[i]);
+    }
+}
+
+// Ensures that repeated vendor names and unpackable dates are stored once.
+TEST_CASE("VendorList: interning") {
+    VendorList list;
+
+    for (int64_t p = 0; p < 100; p++) {
+        list.emplace_back(p, 6, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17");
+        list.emplace_back(p << 4, 7, "Xerox Corporation", false, Registry::MA_M, "unknown");
+    }
+
+    // Two names and one raw date
+    REQUIRE(list.pool_size() == 3);
+    REQUIRE(list.row(0).name == list.row(198).name);
+    REQUIRE(list.row(0).last_update == list.row(198).last_update);
+
+    // Copies own their pools and keep interning consistent
+    VendorList copy = list;
+    list            = VendorList{};
+
+    copy.emplace_back(0x00000C, 6, "Xerox Corporation", false, Registry::MA_L, "");
+
+    REQUIRE(copy.pool_size() == 3);
+    REQUIRE(copy.name_of(copy.row(200)) == "Xerox Corporation");
+    REQUIRE(copy.row(200).name == copy.row(1).name);
+}
+
+// Ensures that sort orders records by cache key.
+TEST_CASE("VendorList: sort") {
+    VendorList list;
+
+    list.emplace_back(0x00000C1, 7, "b", false, Registry::MA_M, "");
+    list.emplace_back(0x00000D, 6, "c", false, Registry::MA_L, "");
+    list.emplace_back(0x00000C, 6, "a", false, Registry::MA_L, "");
+
+    list.sort();
+
+    REQUIRE(list.name_of(list.row(0)) == "a");
+    REQUIRE(list.name_of(list.row(1)) == "b");
+    REQUIRE(list.name_of(list.row(2)) == "c");
+}
+
+// Ensures that sort_unique orders and de-duplicates records like std::set,
+// keeping the first record of each key.
+TEST_CASE("VendorList: sort_unique") {
+    VendorList list;
+
+    list.emplace_back(0x00000D, 6, "c", false, Registry::MA_L, "");
+    list.emplace_back(0x00000C, 6, "a", false, Registry::MA_L, "");
+    list.emplace_back(0x00000C1, 7, "b", false, Registry::MA_M, "");
+    list.emplace_back(0x00000C, 6, "duplicate", false, Registry::MA_L, "");
+    list.emplace_back(0x00000D, 6, "duplicate", false, Registry::MA_L, "");
+
+    const std::set<Vendor> expected(list.begin(), list.end());
+
+    list.sort_unique();
+
+    REQUIRE(std::ranges::equal(list, expected));
+
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.name_of(list.row(0)) == "a");
+    REQUIRE(list.name_of(list.row(1)) == "b");
+    REQUIRE(list.name_of(list.row(2)) == "c");
+}
+
+// Ensures that records copied between lists are re-interned
+// in the pool of the destination list.
+TEST_CASE("VendorList: copy between lists") {
+    VendorList src;
+
+    src.emplace_back(0x00000C, 6, "Cisco Systems, Inc", false, Registry::MA_L, "2015/11/17");
+    src.emplace_back(0x0000AA, 6, "XEROX CORPORATION", false, Registry::MA_L, "unknown");
+
+    VendorList dst;
+
+    dst.emplace_back(0x000001, 6, "XEROX CORPORATION", false, Registry::MA_L, "");
+    dst.emplace_back(src, 1);
+    dst.emplace_back(src, 0);
+
+    REQUIRE(dst.size() == 3);
+    REQUIRE(dst[1] == src[1]);
+    REQUIRE(dst[2] == src[0]);
+    REQUIRE(dst.row(0).name == dst.row(1).name);
+
+    // Two names and one raw date
+    REQUIRE(dst.pool_size() == 3);
+}
@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_exception.hpp>
 
+#include <algorithm>
 #include <map>
 
 #include "exception.hpp"
@@ -15,9 +16,9 @@ TEST_CASE("build_query_by_id_stmt") {
     };
 
     const test_case cases[] = {
-        {1, "SELECT * FROM vendors WHERE prefix IN (?)"},
-        {2, "SELECT * FROM vendors WHERE prefix IN (?,?)"},
-        {3, "SELECT * FROM vendors WHERE prefix IN (?,?,?)"},
+        {1, "SELECT * FROM vendor_rows WHERE prefix IN (?)"},
+        {2, "SELECT * FROM vendor_rows WHERE prefix IN (?,?)"},
+        {3, "SELECT * FROM vendor_rows WHERE prefix IN (?,?,?)"},
     };
 
     for (auto& c : cases) {
@@ -38,23 +39,25 @@ TEST_CASE("construct_queries") {
     };
 
     const test_case cases[] = {
-        {"000000", {0x000000}},
-        {"5CF286D", {0x5CF286, 0x5CF286D}},
-        {"8C1F64F5A", {0x8C1F64, 0x8C1F64F, 0x8C1F64F5A}},
-        {"8C1F64F5A000", {0x8C1F64, 0x8C1F64F, 0x8C1F64F5A}},
-        {"000222", {0x000222}},
-        {"0242", {0x024200}},                                           // 02:42 received
-        {"024200", {0x024200}},                                         // 02:42:00 received, which is how Docker is represented in cache
-        {"000242", {0x000242}},                                         // Videoframe Systems - conflict if Docker was represented by 0x0242
-        {"024256789012", {0x024256, 0x0242567, 0x024256789, 0x024200}}, // Full Docker container's MAC address
-        {"02421", {0x024200}},                                          // Allow shorter query for Docker prefix
+        {"000000", {0x0000000000006}},
+        {"5CF286D", {0x5CF2860000006, 0x5CF286D000007}},
+        {"8C1F64F5A", {0x8C1F640000006, 0x8C1F64F000007, 0x8C1F64F5A0009}},
+        {"8C1F64F5A000", {0x8C1F640000006, 0x8C1F64F000007, 0x8C1F64F5A0009}},
+        {"000222", {0x0002220000006}},
+        {"0242", {0x0242000000006}},                                                            // 02:42 received
+        {"024200", {0x0242000000006}},                                                          // 02:42:00 received, which is how Docker is represented in cache
+        {"000242", {0x0002420000006}},                                                          // Videoframe Systems - conflict if Docker was represented by 0x0242
+        {"024256789012", {0x0242560000006, 0x0242567000007, 0x0242567890009, 0x0242000000006}}, // Full Docker container's MAC address
+        {"00-00-0C-12-34-56", {0x00000C0000006, 0x00000C1000007, 0x00000C1230009}},
+        {"0000.0C12.3456", {0x00000C0000006, 0x00000C1000007, 0x00000C1230009}},
+        {"02421", {0x0242000000006}},                                                           // Allow shorter query for Docker prefix
     };
 
     for (const auto& c : cases) {
-        std::vector<int64_t> out = construct_queries(c.input);
+        const Queries out = construct_queries(c.input);
 
         CAPTURE(c.input);
-        REQUIRE(out == c.expected);
+        REQUIRE(std::ranges::equal(out, c.expected));
     }
 
     const auto too_short = errors::Error{"specified MAC address is too short"};
@@ -80,47 +83,6 @@ TEST_CASE("construct_queries") {
     }
 }
 
-TEST_CASE("get_ieee_block") {
-    struct test_case {
-        size_t      block_length;
-        std::string input;
-        std::string expected;
-    };
-
-    const test_case cases[] = {
-        {6, "000000", "000000"},
-        {6, "5CF286D", "5CF286"},
-        {7, "5CF286D", "5CF286D"},
-        {6, "8C1F64F5A", "8C1F64"},
-        {9, "8C1F64F5A", "8C1F64F5A"},
-        {9, "8C1F64F5A000", "8C1F64F5A"},
-    };
-
-    std::optional<std::string> out;
-
-    for (const auto& c : cases) {
-        CAPTURE(c.input, c.block_length);
-
-        out = get_ieee_block(c.input, c.block_length);
-
-        REQUIRE(out.has_value());
-        REQUIRE(out.value() == c.expected);
-    }
-
-    const test_case nullopt_cases[] = {
-        {6, "00", ""},
-        {7, "00", ""},
-        {9, "00", ""},
-    };
-
-    for (const auto& nc : nullopt_cases) {
-        CAPTURE(nc.input, nc.block_length);
-
-        out = get_ieee_block(nc.input, nc.block_length);
-        REQUIRE(!out.has_value());
-    }
-}
-
 TEST_CASE("escape_spec_chars") {
     const std::map<const std::string, const std::string> csv_cases = {
         {R"(IEE&E "Black" ops)", R"(IEE&E ""Black"" ops)"},
@@ -158,6 +120,172 @@ TEST_CASE("escape_spec_chars") {
     }
 }
 
+TEST_CASE("like_literals") {
+    // <pattern, expected>
+    const std::map<std::string, std::vector<std::string>> cases = {
+        {"cisco", {"cisco"}},
+        {"c_sco", {"c", "sco"}},
+        {"%cis%%sys%", {"cis", "sys"}},
+        {"%", {}},
+        {R"(100\%)", {"100%"}},
+        {R"(a\_b_c)", {"a_b", "c"}},
+        {R"(inc\)", {"inc"}},
+    };
+
+    for (const auto& [pattern, expected] : cases) {
+        CAPTURE(pattern);
+        REQUIRE(like_literals(pattern) == expected);
+    }
+}
+
+// Ensures that like_match agrees with SQLite's LIKE operator with ESCAPE '\'.
+TEST_CASE("like_match") {
+    struct test_case {
+        std::string str;
+        std::string pattern;
+        bool        expected;
+    };
+
+    const test_case cases[] = {
+        {"Cisco Systems, Inc", "%cisco%", true},
+        {"Cisco Systems, Inc", "%CISCO SYS%", true},
+        {"Cisco", "cisco", true},
+        {"Cisco", "c_sco", true},
+        {"Cisco", "c%o", true},
+        {"Cisco", "c%x", false},
+        {"Cisco", "%", true},
+        {"", "%", true},
+        {"100%", R"(%0\%)", true},  // Escaped '%'
+        {"1000", R"(%0\%)", false}, // Escaped '%'
+        {"a_b", R"(%\_%)", true},   // Escaped '_'
+        {"ab", R"(%\_%)", false},   // Escaped '_'
+        {"Zażółć", "za_ółć", true}, // '_' matches a multi-byte character
+        {"Zażółć", "ZA%Ć", false},  // Non-ASCII letters are case-sensitive
+        {"abc", R"(abc\)", false},  // Trailing escape character
+        {"abc", "%b%c%", true},
+        {"ab", "%b%c%", false},
+        {"mississippi", "%iss%ipp%", true}, // Backtracking
+    };
+
+    for (const auto& c : cases) {
+        CAPTURE(c.str, c.pattern);
+        REQUIRE(like_match(c.str, c.pattern) == c.expected);
+    }
+}
+
+// Ensures that make_key keeps blocks of different lengths apart and orders
+// keys by address first, then by block length. Checks that split_key
+// reverses the encoding.
+TEST_CASE("make_key, split_key") {
+    struct test_case {
+        int64_t prefix;
+        size_t  len;
+        int64_t expected;
+    };
+
+    const test_case cases[] = {
+        {0x000000, 6, 0x0000000000006},
+        {0x0000000, 7, 0x0000000000007},
+        {0x00000C, 6, 0x00000C0000006},
+        {0x00000C1, 7, 0x00000C1000007},
+        {0x5CF286D, 7, 0x5CF286D000007},
+        {0x8C1F64FFC, 9, 0x8C1F64FFC0009},
+        {0xFFFFFFFFFFFF, 12, 0xFFFFFFFFFFFFC},
+    };
+
+    for (const auto& c : cases) {
+        CAPTURE(c.prefix, c.len);
+
+        REQUIRE(make_key(c.prefix, c.len) == c.expected);
+        REQUIRE(split_key(c.expected) == std::pair{c.prefix, c.len});
+    }
+
+    // 00:00:0C:1 must not collide with 00:00:C1, as plain integers would
+    REQUIRE(make_key(0x00000C1, 7) != make_key(0x0000C1, 6));
+
+    // Blocks are ordered by address, ancestors before descendants
+    REQUIRE(make_key(0x00000C, 6) < make_key(0x00000C1, 7));
+    REQUIRE(make_key(0x00000C1, 7) < make_key(0x00000C100, 9));
+    REQUIRE(make_key(0x00000C100, 9) < make_key(0x00000C2, 7));
+    REQUIRE(make_key(0x00000C2, 7) < make_key(0x00000D, 6));
+}
+
+// Ensures that parse_addr decodes every supported notation into
+// the same left-aligned value and rejects invalid characters.
+TEST_CASE("normalize_name") {
+    // <name, expected>
+    const std::map<std::string, std::string> cases = {
+        {"Cisco Systems, Inc", "cisco systems"},
+        {"XEROX CORPORATION", "xerox"},
+        {"  Hon Hai  Precision Ind. Co.,Ltd.", "hon hai precision ind"},
+        {"PCS Systemtechnik GmbH (VirtualBox)", "pcs systemtechnik gmbh virtualbox"},
+        {"Inc", "inc"},          // First word is kept
+        {"Co Ltd", "co"},
+        {"Incorporeal", "incorporeal"},
+        {"QEMU/KVM", "qemu kvm"},
+        {"Żółć Sp. z o.o.", "Żółć sp z o o"}, // Non-ASCII bytes are kept
+        {"---", ""},
+        {"", ""},
+    };
+
+    for (const auto& [name, expected] : cases) {
+        CAPTURE(name);
+        REQUIRE(normalize_name(name) == expected);
+    }
+}
+
+TEST_CASE("parse_addr") {
+    struct test_case {
+        std::string input;
+        int64_t     value;
+        size_t      len;
+    };
+
+    const test_case cases[] = {
+        {"00:00:0C:12:34:56", 0x00000C123456, 12}, // Colon
+        {"00-00-0C-12-34-56", 0x00000C123456, 12}, // Dash
+        {"0000.0C12.3456", 0x00000C123456, 12},    // Cisco dot
+        {"00000C123456", 0x00000C123456, 12},      // Bare hex
+        {"00000c123456", 0x00000C123456, 12},      // Lower-case hex
+        {"00:00-0C.12:3456", 0x00000C123456, 12},  // Mixed separators
+        {"00:::00::::0C", 0x00000C000000, 6},      // Many separators in row
+        {"5CF286D", 0x5CF286D00000, 7},            // Partial
+        {"8C:1F:64:F5:A", 0x8C1F64F5A000, 9},      // Partial, odd length
+        {"0242", 0x024200000000, 4},               // Too short for a block
+        {"00000C1234567890", 0x00000C123456, 12},  // Digits past the address are ignored
+        {"", 0, 0},
+        {":-.", 0, 0},
+    };
+
+    for (const auto& c : cases) {
+        CAPTURE(c.input);
+
+        const MacAddr out = parse_addr(c.input);
+
+        REQUIRE(out.value == c.value);
+        REQUIRE(out.len == c.len);
+    }
+
+    const std::string throw_cases[] = {
+        "0002w22",
+        "00:00:0C:12:34:5x",  // Invalid character past the MA-S block
+        "00000C1234567890xx", // Invalid character past the address
+        "00 00 0C",           // Space is not a separator
+        "00_00_0C",
+        "\xFF\xFE\xFD\xFC\xFB\xFA",
+    };
+
+    for (const auto& c : throw_cases) {
+        CAPTURE(c);
+
+        REQUIRE_THROWS_MATCHES(
+            parse_addr(c),
+            errors::Error,
+            Catch::Matchers::Message("specified MAC address contains invalid characters")
+        );
+    }
+}
+
 // Ensures that prefix_to_int returns a correct numerical value.
 TEST_CASE("prefix_to_int") {
     const std::map<std::string, int64_t> cases = {
@@ -203,6 +331,24 @@ TEST_CASE("prefix_to_string") {
         CAPTURE(input);
         REQUIRE(prefix_to_string(input) == expected);
     }
+
+    struct test_case {
+        int64_t     prefix;
+        size_t      len;
+        std::string expected;
+    };
+
+    const test_case len_cases[] = {
+        {0x0000000, 7, "00:00:00:0"},
+        {0x00000C1, 7, "00:00:0C:1"},
+        {0x000000000, 9, "00:00:00:00:0"},
+        {0x00000C100, 9, "00:00:0C:10:0"},
+    };
+
+    for (const auto& c : len_cases) {
+        CAPTURE(c.prefix, c.len);
+        REQUIRE(prefix_to_string(c.prefix, c.len) == c.expected);
+    }
 }
 
 TEST_CASE("replace_escaped_quotes") {
@@ -221,3 +367,58 @@ TEST_CASE("replace_escaped_quotes") {
         REQUIRE(mod == expected);
     }
 }
+
+TEST_CASE("split_lines") {
+    using blocks = std::vector<std::string_view>;
+
+    REQUIRE(split_lines("", 4).empty());
+    REQUIRE(split_lines("abc", 0) == blocks{"abc"});
+    REQUIRE(split_lines("abc", 4) == blocks{"abc"});
+    REQUIRE(split_lines("a\nb\nc\nd\n", 2) == blocks{"a\nb\n", "c\nd\n"});
+    REQUIRE(split_lines("a\nb\nc\nd", 4) == blocks{"a\n", "b\n", "c\n", "d"});
+    REQUIRE(split_lines("long line\nx\n", 3) == blocks{"long line\n", "x\n"});
+
+    // Blocks cover the text and end at line boundaries
+    std::string text;
+    for (int i = 0; i < 1000; i++) {
+        text += std::string(static_cast<size_t>(i % 37), 'x') + '\n';
+    }
+
+    for (size_t n = 1; n <= 16; n++) {
+        CAPTURE(n);
+
+        const auto parts = split_lines(text, n);
+        REQUIRE(parts.size() <= n);
+
+        std::string joined;
+        for (const auto p : parts) {
+            REQUIRE(p.ends_with('\n'));
+            joined += p;
+        }
+        REQUIRE(joined == text);
+    }
+}
+
+TEST_CASE("trigram_query") {
+    // <pattern, expected>
+    const std::map<std::string, std::string> cases = {
+        {"cisco", R"("cisco")"},
+        {"cisco sys", R"("cisco sys")"},
+        {"c_sco", R"("sco")"},
+        {"x%n", ""},
+        {"ab", ""},
+        {"%", ""},
+        {"cis%sys", R"("cis" AND "sys")"},
+        {R"(100\%)", R"("100%")"},  // Escaped '%' is literal
+        {R"(a\_b)", R"("a_b")"},    // Escaped '_' is literal
+        {R"(inc\)", R"("inc")"},    // Trailing escape character
+        {R"(say "hi")", R"("say ""hi""")"},
+        {"żół", R"("żół")"},        // Characters, not bytes, are counted
+        {"żó", ""},
+    };
+
+    for (const auto& [pattern, expected] : cases) {
+        CAPTURE(pattern);
+        REQUIRE(trigram_query(pattern) == expected);
+    }
+}